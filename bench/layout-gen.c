@@ -0,0 +1,61 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+/* generates random layout descriptions in the format of the dump command,
+ * one per line. Each tree is split as deep as load allows, so every
+ * description has 511 frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_SPLITS 4 /* HERBST_MAX_TREE_HEIGHT + 1 per alignment */
+#define MAX_WINDOWS 5
+
+static const char* g_align_names[] = { "vertical", "horizontal" };
+static const char* g_layout_names[] = { "vertical", "horizontal", "max", "grid" };
+
+static unsigned long g_next_window = 0x1a00003;
+
+static void print_frame(int* splits) {
+    int align = rand() % 2;
+    if (splits[align] >= MAX_SPLITS) {
+        align = !align;
+    }
+    if (splits[align] >= MAX_SPLITS) {
+        int count = rand() % (MAX_WINDOWS + 1);
+        printf("(clients %s:%d", g_layout_names[rand() % 4],
+               count ? rand() % count : 0);
+        for (int i = 0; i < count; i++) {
+            printf(" 0x%lx", g_next_window);
+            g_next_window += 0x200000;
+        }
+        putchar(')');
+        return;
+    }
+    printf("(split %s:%lf:%d ", g_align_names[align],
+           0.1 + (rand() % 800) / 1000.0, rand() % 2);
+    splits[align]++;
+    print_frame(splits);
+    putchar(' ');
+    print_frame(splits);
+    splits[align]--;
+    putchar(')');
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s COUNT [SEED]\n", argv[0]);
+        return 1;
+    }
+    int count = atoi(argv[1]);
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+    for (int i = 0; i < count; i++) {
+        int splits[2] = { 0, 0 };
+        print_frame(splits);
+        putchar('\n');
+    }
+    return 0;
+}
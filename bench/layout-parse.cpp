@@ -0,0 +1,78 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+/* times the parser of the load command without an X server. It reads one
+ * layout description per line from stdin, e.g. from layout-gen, and parses
+ * all of them ROUNDS times.
+ */
+
+#include "globals.h"
+#include "command.h"
+#include "layout.h"
+#include "utils.h"
+
+#include "glib-backports.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the globals of main.cpp, which is not linked into the benchmark
+int         g_verbose = 0;
+Display*    g_display;
+int         g_screen;
+Window      g_root;
+int         g_screen_width;
+int         g_screen_height;
+CommandBinding g_commands[] = {
+    { CommandBindingCB() }
+};
+
+int main(int argc, char* argv[]) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 10;
+    GString* input = g_string_new("");
+    char buf[BUFSIZ];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+        g_string_append_len(input, buf, len);
+    }
+    gchar** lines = g_strsplit(input->str, "\n", 0);
+    g_string_free(input, true);
+    int count = 0;
+    size_t frames = 0;
+    size_t bytes = 0;
+    for (int i = 0; lines[i]; i++) {
+        if (lines[i][0] == '\0') {
+            continue;
+        }
+        count++;
+        for (char* c = lines[i]; *c; c++) {
+            frames += (*c == LAYOUT_DUMP_BRACKETS[0]);
+        }
+        bytes += strlen(lines[i]);
+    }
+    if (count == 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [ROUNDS] < DESCRIPTIONS\n", argv[0]);
+        return 1;
+    }
+
+    GString* errormsg = g_string_new("");
+    long long start = get_monotonic_msec();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; lines[i]; i++) {
+            if (lines[i][0] != '\0' && !check_frame_tree(lines[i], errormsg)) {
+                fprintf(stderr, "line %d: %s", i + 1, errormsg->str);
+                return 1;
+            }
+        }
+    }
+    long long msec = get_monotonic_msec() - start;
+    printf("%d descriptions, %zu frames, %zu bytes, %d rounds: %lld ms\n",
+           count, frames, bytes, rounds, msec);
+    printf("%.3f ms per round, %.1f ns per frame\n",
+           (double)msec / rounds, msec * 1e6 / ((double)frames * rounds));
+    g_string_free(errormsg, true);
+    g_strfreev(lines);
+    return 0;
+}
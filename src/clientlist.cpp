@@ -193,6 +193,7 @@ static GString* client_attr_urgent(HSAttribute* attr) {
 static GString* client_attr_sh_tiling(HSAttribute* attr) {
     HSClient* client = container_of(attr->value.b, HSClient, sizehints_tiling);
     if (!is_client_floated(client) && !client->pseudotile) {
+        client_set_layout_dirty(client);
         HSMonitor* mon = find_monitor_with_tag(client->tag);
         if (mon) {
             monitor_apply_layout(mon);
@@ -204,6 +205,7 @@ static GString* client_attr_sh_tiling(HSAttribute* attr) {
 static GString* client_attr_sh_floating(HSAttribute* attr) {
     HSClient* client = container_of(attr->value.b, HSClient, sizehints_floating);
     if (!is_client_floated(client) || client->pseudotile) {
+        client_set_layout_dirty(client);
         HSMonitor* mon = find_monitor_with_tag(client->tag);
         if (mon) {
             monitor_apply_layout(mon);
@@ -443,7 +445,7 @@ static int client_get_scheme_triple_idx(HSClient* client) {
 
 bool client_needs_minimal_dec(HSClient* client, HSFrame* frame) {
     if (!frame) {
-        frame = find_frame_with_client(client->tag->frame, client);
+        frame = client->frame;
         HSAssert(frame != NULL);
     }
     if (!smart_window_surroundings_active(frame)) return false;
@@ -556,9 +558,17 @@ static HSDecorationScheme client_scheme_from_triple(HSClient* client, int tripid
 }
 
 void client_resize_tiling(HSClient* client, Rectangle rect, HSFrame* frame) {
+    HSDecorationPlan plan;
+    client_plan_tiling(client, rect, frame, &plan);
+    decoration_apply_plan(client, &plan);
+}
+
+void client_plan_tiling(HSClient* client, Rectangle rect, HSFrame* frame,
+                        HSDecorationPlan* plan) {
     HSMonitor* m;
     if (client->fullscreen && (m = find_monitor_with_tag(client->tag))) {
-        client_resize_fullscreen(client, m);
+        decoration_plan_outline(client, m->rect,
+            client_scheme_from_triple(client, HSDecSchemeFullscreen), plan);
         return;
     }
     // apply border width
@@ -581,7 +591,7 @@ void client_resize_tiling(HSClient* client, Rectangle rect, HSFrame* frame) {
     if (client_needs_minimal_dec(client, frame)) {
         scheme = client_scheme_from_triple(client, HSDecSchemeMinimal);
     }
-    decoration_resize_outline(client, rect, scheme);
+    decoration_plan_outline(client, rect, scheme, plan);
 }
 
 // from dwm.c
@@ -915,6 +925,7 @@ void client_set_fullscreen(HSClient* client, bool state) {
         stack_slice_remove_layer(stack, client->slice, LAYER_FULLSCREEN);
     }
     tag_update_focus_layer(client->tag);
+    client_set_layout_dirty(client);
     monitor_apply_layout(find_monitor_with_tag(client->tag));
 
     char buf[STRING_BUF_SIZE];
@@ -925,9 +936,14 @@ void client_set_fullscreen(HSClient* client, bool state) {
 
 void client_set_pseudotile(HSClient* client, bool state) {
     client->pseudotile = state;
+    client_set_layout_dirty(client);
     monitor_apply_layout(find_monitor_with_tag(client->tag));
 }
 
+void client_set_layout_dirty(HSClient* client) {
+    frame_set_dirty(client->frame);
+}
+
 int client_set_property_command(int argc, char** argv) {
     const char* action = (argc > 1) ? argv[1] : "toggle";
 
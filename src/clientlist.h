@@ -25,6 +25,8 @@ typedef struct HSClient {
     GString*    window_str;     // the window id as a string
     Rectangle   last_size;      // last size excluding the window border
     HSTag*      tag;
+    struct HSFrame* frame;      // the frame containing the client
+    int         frame_index;    // index in frame->content.clients.buf
     Rectangle   float_size;     // floating size without the window border
     GString*    title;  // or also called window title; this is never NULL
     GString*    keymask; // keymask applied to mask out keybindins
@@ -38,6 +40,10 @@ typedef struct HSClient {
     bool        sizehints_floating;  // respect size hints regarding this client in floating mode
     bool        sizehints_tiling;  // respect size hints regarding this client in tiling mode
     bool        dragged;  // if this client is dragged currently
+    // the button grabs on the window, see grab_client_buttons()
+    int         grabbed_generation; // 0 if unknown
+    bool        grabbed_focused;
+    unsigned int grabbed_numlockmask;
     int         pid;
     int         ignore_unmaps;  // Ignore one unmap for each reparenting
                                 // action, because reparenting creates an unmap
@@ -88,6 +94,10 @@ Window string_to_client(const char* str, HSClient** ret_client);
 void client_setup_border(HSClient* client, bool focused);
 void client_resize(HSClient* client, Rectangle rect, HSFrame* frame);
 void client_resize_tiling(HSClient* client, Rectangle rect, HSFrame* frame);
+// compute the geometry and scheme client_resize_tiling() would apply
+// without touching the X server or the client
+void client_plan_tiling(HSClient* client, Rectangle rect, HSFrame* frame,
+                        HSDecorationPlan* plan);
 void client_resize_floating(HSClient* client, HSMonitor* m);
 bool is_client_floated(HSClient* client);
 bool client_needs_minimal_dec(HSClient* client, HSFrame* frame);
@@ -109,6 +119,9 @@ bool client_sendevent(HSClient *client, Atom proto);
 
 void client_set_fullscreen(HSClient* client, bool state);
 void client_set_pseudotile(HSClient* client, bool state);
+// marks the frame containing the client dirty, i.e. the client's tiling
+// geometry is recomputed on the next layout
+void client_set_layout_dirty(HSClient* client);
 // sets a client property, depending on argv[0]
 int client_set_property_command(int argc, char** argv);
 bool is_window_class_ignored(char* window_class);
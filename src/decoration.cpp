@@ -4,6 +4,8 @@
 #include "globals.h"
 #include "settings.h"
 #include "ewmh.h"
+#include "mouse.h"
+#include "floating.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -13,9 +15,35 @@ HSDecTriple g_decorations[HSDecSchemeCount];
 
 // module intern globals:
 static GHashTable* g_decwin2client = NULL;
+// incremented whenever a scheme color changes, invalidates the color caches
+static int g_color_generation = 0;
 
 static int* g_pseudotile_center_threshold;
 static int* g_update_dragged_clients;
+static int* g_decoration_pixmaps;
+// decorations drawn in an older generation need to be redrawn
+static int g_drawn_generation = 1;
+
+// pixmaps that are not used by any decoration, for later reuse
+typedef struct {
+    Pixmap          pixmap;
+    unsigned int    depth;
+    int             width;
+    int             height;
+    long long       released; // in milliseconds
+} HSDecPixmap;
+static GArray* g_pixmap_pool = NULL; // of HSDecPixmap
+// pixmap sizes are rounded up to a multiple of this
+#define DEC_PIXMAP_STEP 128
+// pixmaps unused for that many milliseconds are freed
+#define DEC_PIXMAP_IDLE 10000
+#define DEC_PIXMAP_POOL_MAX 8
+// one GC for each depth, lazily created
+typedef struct {
+    unsigned int    depth;
+    GC              gc;
+} HSDecGC;
+static GArray* g_decoration_gcs = NULL; // of HSDecGC
 static HSObject* g_theme_object;
 static HSObject g_theme_active_object;
 static HSObject g_theme_normal_object;
@@ -32,12 +60,16 @@ static GString* PROP2MEMBERS(HSAttribute* attr);
 
 // is called automatically after resize_outline
 static void decoration_update_frame_extents(struct HSClient* client);
+static void decoration_release_pixmap(HSDecoration* dec);
 
 void decorations_init() {
     g_theme_object = hsobject_create_and_link(hsobject_root(), "theme");
     g_pseudotile_center_threshold = &(settings_find("pseudotile_center_threshold")->value.i);
     g_update_dragged_clients = &(settings_find("update_dragged_clients")->value.i);
+    g_decoration_pixmaps = &(settings_find("decoration_pixmaps")->value.i);
     g_decwin2client = g_hash_table_new(g_int_hash, g_int_equal);
+    g_pixmap_pool = g_array_new(false, false, sizeof(HSDecPixmap));
+    g_decoration_gcs = g_array_new(false, false, sizeof(HSDecGC));
     // init default schemes
     // tiling //
     HSDecTriple tiling = {
@@ -89,7 +121,9 @@ void decorations_init() {
 }
 
 static GString* RELAYOUT(HSAttribute* attr) {
-    (void) attr;
+    if (attr->type == HSATTR_TYPE_COLOR) {
+        g_color_generation++;
+    }
     all_monitors_apply_layout();
     return NULL;
 }
@@ -243,6 +277,16 @@ void decorations_destroy() {
     hsobject_unlink_and_destroy(hsobject_root(), g_theme_object);
     g_hash_table_destroy(g_decwin2client);
     g_decwin2client = NULL;
+    for (int i = 0; i < g_pixmap_pool->len; i++) {
+        XFreePixmap(g_display, g_array_index(g_pixmap_pool, HSDecPixmap, i).pixmap);
+    }
+    g_array_free(g_pixmap_pool, true);
+    g_pixmap_pool = NULL;
+    for (int i = 0; i < g_decoration_gcs->len; i++) {
+        XFreeGC(g_display, g_array_index(g_decoration_gcs, HSDecGC, i).gc);
+    }
+    g_array_free(g_decoration_gcs, true);
+    g_decoration_gcs = NULL;
 }
 
 // from openbox/frame.c
@@ -317,6 +361,13 @@ void decoration_setup_frame(HSClient* client) {
     dec->last_actual_rect = dec->last_inner_rect;
     dec->last_actual_rect.x -= dec->last_outer_rect.x;
     dec->last_actual_rect.y -= dec->last_outer_rect.y;
+    // the geometry the windows were created with
+    dec->applied_outer_rect = Rectangle(0, 0, 30, 30);
+    dec->applied_client_rect = Rectangle(0, 0, -1, -1); // unknown
+    dec->applied_inner_rect = Rectangle(0, 0, -1, -1); // unknown
+    for (int i = 0; i < LENGTH(dec->applied_extents); i++) {
+        dec->applied_extents[i] = -1;
+    }
     dec->pixmap = 0;
     g_hash_table_insert(g_decwin2client, &(dec->decwin), client);
     // set wm_class for window
@@ -331,10 +382,17 @@ void decoration_free(HSDecoration* dec) {
     if (g_decwin2client) {
         g_hash_table_remove(g_decwin2client, &(dec->decwin));
     }
+    if (dec->colors) {
+        // the pixels are released together with the colormap
+        g_array_free(dec->colors, true);
+        dec->colors = NULL;
+    }
     if (dec->colormap) {
         XFreeColormap(g_display, dec->colormap);
     }
-    if (dec->pixmap) {
+    if (dec->pixmap && g_pixmap_pool) {
+        decoration_release_pixmap(dec);
+    } else if (dec->pixmap) {
         XFreePixmap(g_display, dec->pixmap);
     }
     if (dec->bgwin) {
@@ -373,14 +431,10 @@ void decoration_resize_inner(HSClient* client, Rectangle inner,
     client->dec.last_rect_inner = true;
 }
 
-void decoration_resize_outline(HSClient* client, Rectangle outline,
-                               HSDecorationScheme scheme)
+void decoration_plan_outline(HSClient* client, Rectangle outline,
+                             HSDecorationScheme scheme, HSDecorationPlan* plan)
 {
     Rectangle inner = outline_to_inner_rect(outline, scheme);
-    // get relative coordinates
-    Window decwin = client->dec.decwin;
-    Window win = client->window;
-
     Rectangle tile = inner;
     applysizehints(client, &inner.width, &inner.height);
     if (!scheme.tight_decoration) {
@@ -393,78 +447,127 @@ void decoration_resize_outline(HSClient* client, Rectangle outline,
         inner.x = tile.x + ((dx < threshold) ? 0 : dx);
         inner.y = tile.y + ((dy < threshold) ? 0 : dy);
     }
-
-    //if (RECTANGLE_EQUALS(client->last_size, rect)
-    //    && client->last_border_width == border_width) {
-    //    return;
-    //}
-
     if (scheme.tight_decoration) {
         outline = inner_rect_to_outline(inner, scheme);
     }
-    client->dec.last_inner_rect = inner;
-    inner.x -= outline.x;
-    inner.y -= outline.y;
-    XWindowChanges changes;
-    changes.x = inner.x;
-    changes.y = inner.y;
-    changes.width = inner.width;
-    changes.height = inner.height;
-    changes.border_width = 0;
-
-    int mask = CWX | CWY | CWWidth | CWHeight | CWBorderWidth;
-    //if (*g_window_border_inner_width > 0
-    //    && *g_window_border_inner_width < *g_window_border_width) {
-    //    unsigned long current_border_color = get_window_border_color(client);
-    //    HSDebug("client_resize %s\n",
-    //            current_border_color == g_window_border_active_color
-    //            ? "ACTIVE" : "NORMAL");
-    //    set_window_double_border(g_display, win, *g_window_border_inner_width,
-    //                             g_window_border_inner_color,
-    //                             current_border_color);
-    //}
-    // send new size to client
+    plan->outline = outline;
+    plan->inner = inner;
+    plan->scheme = scheme;
+    // get relative coordinates
+    plan->client = inner;
+    plan->client.x -= outline.x;
+    plan->client.y -= outline.y;
+}
+
+static bool decoration_scheme_equals(HSDecorationScheme* a,
+                                     HSDecorationScheme* b) {
+    return a->border_width == b->border_width
+        && a->border_color == b->border_color
+        && a->tight_decoration == b->tight_decoration
+        && a->inner_color == b->inner_color
+        && a->inner_width == b->inner_width
+        && a->outer_color == b->outer_color
+        && a->outer_width == b->outer_width
+        && a->padding_top == b->padding_top
+        && a->padding_right == b->padding_right
+        && a->padding_bottom == b->padding_bottom
+        && a->padding_left == b->padding_left
+        && a->background_color == b->background_color;
+}
+
+void decoration_resize_outline(HSClient* client, Rectangle outline,
+                               HSDecorationScheme scheme)
+{
+    HSDecorationPlan plan;
+    decoration_plan_outline(client, outline, scheme, &plan);
+    decoration_apply_plan(client, &plan);
+}
+
+void decoration_apply_plan(HSClient* client, HSDecorationPlan* plan) {
+    HSDecoration* dec = &client->dec;
+    HSDecorationScheme scheme = plan->scheme;
+
     // update structs
-    bool size_changed = outline.width != client->dec.last_outer_rect.width
-                     || outline.height != client->dec.last_outer_rect.height;
-    client->dec.last_outer_rect = outline;
-    client->dec.last_rect_inner = false;
-    client->last_size = inner;
-    client->dec.last_scheme = scheme;
-    // redraw
-    // TODO: reduce flickering
-    if (!client->dragged || *g_update_dragged_clients) {
-        client->dec.last_actual_rect.x = changes.x;
-        client->dec.last_actual_rect.y = changes.y;
-        client->dec.last_actual_rect.width = changes.width;
-        client->dec.last_actual_rect.height = changes.height;
-    }
-    decoration_redraw_pixmap(client);
-    XSetWindowBackgroundPixmap(g_display, decwin, client->dec.pixmap);
-    if (!size_changed) {
-        // if size changes, then the window is cleared automatically
-        XClearWindow(g_display, decwin);
-    }
-    if (!client->dragged || *g_update_dragged_clients) {
-        XConfigureWindow(g_display, win, mask, &changes);
-        XMoveResizeWindow(g_display, client->dec.bgwin,
+    bool size_changed = plan->outline.width != dec->applied_outer_rect.width
+                     || plan->outline.height != dec->applied_outer_rect.height;
+    bool update_client = !client->dragged || *g_update_dragged_clients;
+    // the pixmap only depends on the scheme, the outline size and the
+    // position of the client within the decoration
+    Rectangle old_inner = dec->last_inner_rect;
+    old_inner.x -= dec->last_outer_rect.x;
+    old_inner.y -= dec->last_outer_rect.y;
+    Rectangle new_inner = plan->inner;
+    new_inner.x -= plan->outline.x;
+    new_inner.y -= plan->outline.y;
+    bool redraw = dec->drawn_generation != g_drawn_generation
+        || size_changed
+        || !RECTANGLE_EQUALS(old_inner, new_inner)
+        || !decoration_scheme_equals(&scheme, &dec->last_scheme)
+        || (update_client
+            && !RECTANGLE_EQUALS(plan->client, dec->last_actual_rect));
+    if (redraw && size_changed && client->dragged && mouse_is_dragging()) {
+        // while the size changes during a drag, only move and resize the
+        // decoration window. The details are drawn as soon as the size
+        // stays the same for one motion or the drag ends.
+        dec->drawn_generation = 0;
+        redraw = false;
+    }
+    if (!RECTANGLE_EQUALS(plan->outline, dec->last_outer_rect)) {
+        floating_index_invalidate(client->tag);
+    }
+    dec->last_inner_rect = plan->inner;
+    dec->last_outer_rect = plan->outline;
+    dec->last_rect_inner = false;
+    client->last_size = plan->client;
+    dec->last_scheme = scheme;
+    if (update_client) {
+        dec->last_actual_rect = plan->client;
+    }
+    if (redraw) {
+        decoration_redraw(client, !size_changed);
+    }
+    // only send the geometry requests that change something
+    if (update_client
+        && !RECTANGLE_EQUALS(plan->client, dec->applied_client_rect)) {
+        XWindowChanges changes;
+        changes.x = plan->client.x;
+        changes.y = plan->client.y;
+        changes.width = plan->client.width;
+        changes.height = plan->client.height;
+        changes.border_width = 0;
+        int mask = CWX | CWY | CWWidth | CWHeight | CWBorderWidth;
+        XConfigureWindow(g_display, client->window, mask, &changes);
+        XMoveResizeWindow(g_display, dec->bgwin,
                           changes.x, changes.y,
                           changes.width, changes.height);
+        dec->applied_client_rect = plan->client;
+    }
+    if (!RECTANGLE_EQUALS(plan->outline, dec->applied_outer_rect)) {
+        XMoveResizeWindow(g_display, dec->decwin,
+                          plan->outline.x, plan->outline.y,
+                          plan->outline.width, plan->outline.height);
+        dec->applied_outer_rect = plan->outline;
     }
-    XMoveResizeWindow(g_display, decwin,
-                      outline.x, outline.y, outline.width, outline.height);
     decoration_update_frame_extents(client);
-    if (!client->dragged || *g_update_dragged_clients) {
+    if (update_client
+        && !RECTANGLE_EQUALS(plan->inner, dec->applied_inner_rect)) {
         client_send_configure(client);
+        dec->applied_inner_rect = plan->inner;
     }
-    XSync(g_display, False);
 }
 
 static void decoration_update_frame_extents(struct HSClient* client) {
-    int left = client->dec.last_inner_rect.x - client->dec.last_outer_rect.x;
-    int top  = client->dec.last_inner_rect.y - client->dec.last_outer_rect.y;
-    int right = client->dec.last_outer_rect.width - client->dec.last_inner_rect.width - left;
-    int bottom = client->dec.last_outer_rect.height - client->dec.last_inner_rect.height - top;
+    HSDecoration* dec = &client->dec;
+    int left = dec->last_inner_rect.x - dec->last_outer_rect.x;
+    int top  = dec->last_inner_rect.y - dec->last_outer_rect.y;
+    int right = dec->last_outer_rect.width - dec->last_inner_rect.width - left;
+    int bottom = dec->last_outer_rect.height - dec->last_inner_rect.height - top;
+    int extents[] = { left, right, top, bottom };
+    if (!memcmp(extents, dec->applied_extents, sizeof(extents))) {
+        // property is up to date
+        return;
+    }
+    memcpy(dec->applied_extents, extents, sizeof(extents));
     ewmh_update_frame_extents(client->window, left,right, top,bottom);
 }
 
@@ -481,42 +584,133 @@ void decoration_change_scheme(struct HSClient* client,
     }
 }
 
+// drops all cached colors of dec and releases them in its colormap
+static void decoration_forget_colors(HSDecoration* dec) {
+    if (dec->colors->len > 0) {
+        unsigned long* pixels = g_new(unsigned long, dec->colors->len);
+        for (int i = 0; i < dec->colors->len; i++) {
+            pixels[i] = g_array_index(dec->colors, HSDecColor, i).allocated;
+        }
+        XFreeColors(g_display, dec->colormap, pixels, dec->colors->len, 0);
+        g_free(pixels);
+        g_array_set_size(dec->colors, 0);
+    }
+    dec->colors_generation = g_color_generation;
+}
+
 static unsigned int get_client_color(HSClient* client, unsigned int pixel) {
-    if (client->dec.colormap) {
+    HSDecoration* dec = &client->dec;
+    if (dec->colormap) {
+        if (!dec->colors) {
+            dec->colors = g_array_new(false, false, sizeof(HSDecColor));
+            dec->colors_generation = g_color_generation;
+        } else if (dec->colors_generation != g_color_generation) {
+            decoration_forget_colors(dec);
+        }
+        // only a handful of scheme colors are in use, so a linear scan is
+        // cheaper than a hash table and avoids two round trips per color
+        for (int i = 0; i < dec->colors->len; i++) {
+            HSDecColor* c = &g_array_index(dec->colors, HSDecColor, i);
+            if (c->pixel == pixel) {
+                return c->allocated;
+            }
+        }
         XColor xcol;
         xcol.pixel = pixel;
         /* get rbg value out of default colormap */
         XQueryColor(g_display, DefaultColormap(g_display, g_screen), &xcol);
         /* get pixel value back appropriate for client */
-        XAllocColor(g_display, client->dec.colormap, &xcol);
+        if (!XAllocColor(g_display, dec->colormap, &xcol)) {
+            return xcol.pixel;
+        }
+        HSDecColor c = { pixel, xcol.pixel };
+        g_array_append_val(dec->colors, c);
         return xcol.pixel;
     } else {
         return pixel;
     }
 }
 
-// draw a decoration to the client->dec.pixmap
-void decoration_redraw_pixmap(struct HSClient* client) {
-    HSDecorationScheme s = client->dec.last_scheme;
-    HSDecoration *const dec = &client->dec;
-    Window win = client->dec.decwin;
-    Rectangle outer = client->dec.last_outer_rect;
-    unsigned int depth = client->dec.depth;
-    // TODO: maybe do something like pixmap recreate threshhold?
-    bool recreate_pixmap = (dec->pixmap == 0) || (dec->pixmap_width != outer.width)
-                                              || (dec->pixmap_height != outer.height);
-    if (recreate_pixmap) {
-        if (dec->pixmap) {
-            XFreePixmap(g_display, dec->pixmap);
+// returns the shared GC for drawables of the given depth
+static GC decoration_gc(unsigned int depth, Drawable d) {
+    for (int i = 0; i < g_decoration_gcs->len; i++) {
+        HSDecGC* g = &g_array_index(g_decoration_gcs, HSDecGC, i);
+        if (g->depth == depth) {
+            return g->gc;
         }
-        dec->pixmap = XCreatePixmap(g_display, win, outer.width, outer.height, depth);
     }
-    Pixmap pix = dec->pixmap;
-    GC gc = XCreateGC(g_display, pix, 0, NULL);
+    HSDecGC g = { depth, XCreateGC(g_display, d, 0, NULL) };
+    g_array_append_val(g_decoration_gcs, g);
+    return g.gc;
+}
 
-    // draw background
-    XSetForeground(g_display, gc, get_client_color(client, s.border_color));
-    XFillRectangle(g_display, pix, gc, 0, 0, outer.width, outer.height);
+// whether a pixmap of size pw x ph may be used for a w x h decoration
+static bool dec_pixmap_fits(int pw, int ph, int w, int h) {
+    // do not waste more than the rounding step in each direction
+    return pw >= w && ph >= h
+        && pw < w + DEC_PIXMAP_STEP && ph < h + DEC_PIXMAP_STEP;
+}
+
+// frees pooled pixmaps that were not used for a while
+static void decoration_evict_pixmaps(long long now) {
+    for (int i = g_pixmap_pool->len; i --> 0;) {
+        HSDecPixmap* p = &g_array_index(g_pixmap_pool, HSDecPixmap, i);
+        if (now - p->released >= DEC_PIXMAP_IDLE
+            || g_pixmap_pool->len > DEC_PIXMAP_POOL_MAX) {
+            // the pool is ordered by release time, so the oldest go first
+            XFreePixmap(g_display, p->pixmap);
+            g_array_remove_index(g_pixmap_pool, i);
+        }
+    }
+}
+
+static void decoration_release_pixmap(HSDecoration* dec) {
+    long long now = get_monotonic_msec();
+    HSDecPixmap p = {
+        dec->pixmap, dec->depth, dec->pixmap_width, dec->pixmap_height, now,
+    };
+    g_array_prepend_val(g_pixmap_pool, p);
+    dec->pixmap = 0;
+    decoration_evict_pixmaps(now);
+}
+
+static void decoration_acquire_pixmap(HSDecoration* dec, int width, int height) {
+    decoration_evict_pixmaps(get_monotonic_msec());
+    int best = -1;
+    for (int i = 0; i < g_pixmap_pool->len; i++) {
+        HSDecPixmap* p = &g_array_index(g_pixmap_pool, HSDecPixmap, i);
+        if (p->depth != dec->depth
+            || !dec_pixmap_fits(p->width, p->height, width, height)) {
+            continue;
+        }
+        if (best < 0 || p->width * p->height
+            < g_array_index(g_pixmap_pool, HSDecPixmap, best).width
+            * g_array_index(g_pixmap_pool, HSDecPixmap, best).height) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        HSDecPixmap* p = &g_array_index(g_pixmap_pool, HSDecPixmap, best);
+        dec->pixmap = p->pixmap;
+        dec->pixmap_width = p->width;
+        dec->pixmap_height = p->height;
+        g_array_remove_index(g_pixmap_pool, best);
+        return;
+    }
+    // round up, such that small size changes do not need a new pixmap
+    width = (width + DEC_PIXMAP_STEP - 1) / DEC_PIXMAP_STEP * DEC_PIXMAP_STEP;
+    height = (height + DEC_PIXMAP_STEP - 1) / DEC_PIXMAP_STEP * DEC_PIXMAP_STEP;
+    dec->pixmap = XCreatePixmap(g_display, dec->decwin, width, height,
+                                dec->depth);
+    dec->pixmap_width = width;
+    dec->pixmap_height = height;
+}
+
+// draw the parts of the decoration that do not have the border color
+static void decoration_draw_details(HSClient* client, Drawable d, GC gc) {
+    HSDecorationScheme s = client->dec.last_scheme;
+    HSDecoration *const dec = &client->dec;
+    Rectangle outer = client->dec.last_outer_rect;
 
     // Draw inner border
     int iw = s.inner_width;
@@ -532,7 +726,7 @@ void decoration_redraw_pixmap(struct HSClient* client) {
             { inner.x - iw, inner.y + inner.height, inner.width + 2*iw, iw }, /* bottom */
         };
         XSetForeground(g_display, gc, get_client_color(client, s.inner_color));
-        XFillRectangles(g_display, pix, gc, rects, LENGTH(rects));
+        XFillRectangles(g_display, d, gc, rects, LENGTH(rects));
     }
 
     // Draw outer border
@@ -548,25 +742,117 @@ void decoration_redraw_pixmap(struct HSClient* client) {
             { 0, outer.height - ow, outer.width, ow }, /* bottom */
         };
         XSetForeground(g_display, gc, get_client_color(client, s.outer_color));
-        XFillRectangles(g_display, pix, gc, rects, LENGTH(rects));
+        XFillRectangles(g_display, d, gc, rects, LENGTH(rects));
     }
     // fill inner rect that is not covered by the client
     XSetForeground(g_display, gc, get_client_color(client, s.background_color));
     if (dec->last_actual_rect.width < inner.width) {
-        XFillRectangle(g_display, pix, gc,
+        XFillRectangle(g_display, d, gc,
                        dec->last_actual_rect.x + dec->last_actual_rect.width,
                        dec->last_actual_rect.y,
                        inner.width - dec->last_actual_rect.width,
                        dec->last_actual_rect.height);
     }
     if (dec->last_actual_rect.height < inner.height) {
-        XFillRectangle(g_display, pix, gc,
+        XFillRectangle(g_display, d, gc,
                        dec->last_actual_rect.x,
                        dec->last_actual_rect.y + dec->last_actual_rect.height,
                        inner.width,
                        inner.height - dec->last_actual_rect.height);
     }
-    // clean up
-    XFreeGC(g_display, gc);
+}
+
+void decoration_redraw(struct HSClient* client, bool clear) {
+    HSDecoration *const dec = &client->dec;
+    Window win = dec->decwin;
+    Rectangle outer = dec->last_outer_rect;
+    unsigned long border_color =
+        get_client_color(client, dec->last_scheme.border_color);
+    dec->drawn_generation = g_drawn_generation;
+    if (!*g_decoration_pixmaps) {
+        // paint directly to the window, the server fills everything else
+        // with the border color. So no memory is needed for the area
+        // covered by the client
+        if (dec->pixmap) {
+            decoration_release_pixmap(dec);
+        }
+        XSetWindowBackground(g_display, win, border_color);
+        if (clear) {
+            XClearWindow(g_display, win);
+        }
+        decoration_draw_details(client, win, decoration_gc(dec->depth, win));
+        return;
+    }
+    // the pixmap may be larger than the window, because the background is
+    // tiled from the upper left corner
+    if (dec->pixmap && !dec_pixmap_fits(dec->pixmap_width, dec->pixmap_height,
+                                        outer.width, outer.height)) {
+        decoration_release_pixmap(dec);
+    }
+    if (!dec->pixmap) {
+        decoration_acquire_pixmap(dec, outer.width, outer.height);
+    }
+    Pixmap pix = dec->pixmap;
+    GC gc = decoration_gc(dec->depth, pix);
+    XSetForeground(g_display, gc, border_color);
+    XFillRectangle(g_display, pix, gc, 0, 0, outer.width, outer.height);
+    decoration_draw_details(client, pix, gc);
+    XSetWindowBackgroundPixmap(g_display, win, pix);
+    if (clear) {
+        XClearWindow(g_display, win);
+    }
+}
+
+void decoration_expose(XExposeEvent* ev) {
+    if (ev->count > 0 || *g_decoration_pixmaps) {
+        // wait for the last event, and pixmaps are drawn by the server
+        return;
+    }
+    HSClient* client = get_client_from_decoration(ev->window);
+    if (client && client->dec.drawn_generation == g_drawn_generation) {
+        decoration_redraw(client, false);
+    }
+}
+
+static void decoration_drop_pixmap(gpointer key, gpointer value,
+                                   gpointer data) {
+    (void) key;
+    (void) data;
+    HSDecoration* dec = &((HSClient*)value)->dec;
+    if (dec->pixmap) {
+        // the window keeps its background until it is redrawn
+        XFreePixmap(g_display, dec->pixmap);
+        dec->pixmap = 0;
+    }
+}
+
+void decorations_redraw_all() {
+    if (!*g_decoration_pixmaps) {
+        // give back all the memory, also of the clients on hidden tags
+        clientlist_foreach(decoration_drop_pixmap, NULL);
+        for (int i = 0; i < g_pixmap_pool->len; i++) {
+            XFreePixmap(g_display,
+                        g_array_index(g_pixmap_pool, HSDecPixmap, i).pixmap);
+        }
+        g_array_set_size(g_pixmap_pool, 0);
+    }
+    // the next layout application redraws every decoration
+    g_drawn_generation++;
+    all_monitors_apply_layout();
+}
+
+long long decorations_evict_idle_pixmaps() {
+    if (g_pixmap_pool->len == 0) {
+        return -1;
+    }
+    long long now = get_monotonic_msec();
+    decoration_evict_pixmaps(now);
+    if (g_pixmap_pool->len == 0) {
+        return -1;
+    }
+    // the last one was released first
+    long long released = g_array_index(g_pixmap_pool, HSDecPixmap,
+                                       g_pixmap_pool->len - 1).released;
+    return MAX(released + DEC_PIXMAP_IDLE - now, 0);
 }
 
@@ -36,6 +36,11 @@ typedef struct {
     HSColor background_color; // color behind client contents
 } HSDecorationScheme;
 
+typedef struct {
+    unsigned long   pixel;      // pixel in the default colormap
+    unsigned long   allocated;  // corresponding pixel in the client colormap
+} HSDecColor;
+
 typedef struct {
     struct HSClient*        client; // the client to decorate
     Window                  decwin; // the decoration winodw
@@ -44,10 +49,19 @@ typedef struct {
     Rectangle               last_inner_rect; // only valid if width >= 0
     Rectangle               last_outer_rect; // only valid if width >= 0
     Rectangle               last_actual_rect; // last actual client rect, relative to decoration
+    /* geometry that was sent to the X server last. It is used to skip
+     * requests that would not change anything */
+    Rectangle               applied_outer_rect;
+    Rectangle               applied_client_rect; // relative to decoration
+    Rectangle               applied_inner_rect; // last sent ConfigureNotify
+    int                     applied_extents[4]; // left, right, top, bottom
     /* X specific things */
     Colormap                colormap;
+    GArray*                 colors; // of HSDecColor, allocated in colormap
+    int                     colors_generation;
     unsigned int            depth;
-    Pixmap                  pixmap;
+    int                     drawn_generation;
+    Pixmap                  pixmap; // only used if decoration_pixmaps is set
     int                     pixmap_height;
     int                     pixmap_width;
     // fill the area behind client with another window that does nothing,
@@ -84,6 +98,19 @@ void decoration_init(HSDecoration* dec, struct HSClient* client);
 void decoration_setup_frame(struct HSClient* client);
 void decoration_free(HSDecoration* dec);
 
+// the geometry of a decorated client, computed without touching the X server
+typedef struct {
+    Rectangle   outline; // the decoration window
+    Rectangle   inner;   // the client window
+    Rectangle   client;  // the client window relative to the decoration
+    HSDecorationScheme scheme; // the scheme the decoration is drawn with
+} HSDecorationPlan;
+
+// compute the geometry of a client whose decorated outline fits into rect
+void decoration_plan_outline(struct HSClient* client, Rectangle rect,
+                             HSDecorationScheme scheme, HSDecorationPlan* plan);
+// move, resize and redraw the client and its decoration as planned
+void decoration_apply_plan(struct HSClient* client, HSDecorationPlan* plan);
 // resize such that the decorated outline of the window fits into rect
 void decoration_resize_outline(struct HSClient* client, Rectangle rect,
                                HSDecorationScheme scheme);
@@ -94,7 +121,14 @@ void decoration_resize_inner(struct HSClient* client, Rectangle rect,
 void decoration_change_scheme(struct HSClient* client,
                               HSDecorationScheme scheme);
 
-void decoration_redraw_pixmap(struct HSClient* client);
+// repaint the decoration, and clear the window if clear is set
+void decoration_redraw(struct HSClient* client, bool clear);
+void decoration_expose(XExposeEvent* ev);
+// called if the way decorations are drawn changes
+void decorations_redraw_all();
+// frees the pooled pixmaps that were unused for too long. Returns the
+// milliseconds until the next one expires, or -1 if the pool is empty
+long long decorations_evict_idle_pixmaps();
 struct HSClient* get_client_from_decoration(Window decwin);
 
 Rectangle inner_rect_to_outline(Rectangle rect, HSDecorationScheme scheme);
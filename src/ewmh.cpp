@@ -29,6 +29,21 @@ Atom g_netatom[NetCOUNT];
 // module internal globals:
 static Window*     g_windows; // array with Window-IDs
 static size_t      g_window_count;
+static size_t      g_window_capacity; // allocated length of g_windows
+// number of windows at the beginning of g_windows that already are
+// written to _NET_CLIENT_LIST
+static size_t      g_client_list_written;
+// the root window properties that have to be written on the next flush
+enum {
+    EWMH_DIRTY_CLIENT_LIST          = 1 << 0,
+    EWMH_DIRTY_CLIENT_LIST_STACKING = 1 << 1,
+    EWMH_DIRTY_DESKTOPS             = 1 << 2,
+    EWMH_DIRTY_DESKTOP_NAMES        = 1 << 3,
+    EWMH_DIRTY_CURRENT_DESKTOP      = 1 << 4,
+    EWMH_DIRTY_ACTIVE_WINDOW        = 1 << 5,
+};
+static int         g_ewmh_dirty = 0;
+static Window      g_active_window; // value for _NET_ACTIVE_WINDOW
 static Window      g_wm_window;
 static int*        g_focus_stealing_prevention;
 
@@ -101,6 +116,8 @@ void ewmh_init() {
     /* init some globals */
     g_windows = NULL;
     g_window_count = 0;
+    g_window_capacity = 0;
+    g_client_list_written = 0;
     if (!ewmh_read_client_list(&g_original_clients, &g_original_clients_count))
     {
         g_original_clients = NULL;
@@ -157,9 +174,24 @@ void ewmh_update_wmname() {
 }
 
 void ewmh_update_client_list() {
-    XChangeProperty(g_display, g_root, g_netatom[NetClientList],
-        XA_WINDOW, 32, PropModeReplace,
-        (unsigned char *) g_windows, g_window_count);
+    g_ewmh_dirty |= EWMH_DIRTY_CLIENT_LIST;
+}
+
+// writes _NET_CLIENT_LIST completely if replace is set, or else only
+// appends the windows that were added since it was written last
+static void ewmh_write_client_list(bool replace) {
+    if (replace) {
+        XChangeProperty(g_display, g_root, g_netatom[NetClientList],
+            XA_WINDOW, 32, PropModeReplace,
+            (unsigned char *) g_windows, g_window_count);
+    } else if (g_client_list_written < g_window_count) {
+        // only send the new windows
+        XChangeProperty(g_display, g_root, g_netatom[NetClientList],
+            XA_WINDOW, 32, PropModeAppend,
+            (unsigned char *) (g_windows + g_client_list_written),
+            g_window_count - g_client_list_written);
+    }
+    g_client_list_written = g_window_count;
 }
 
 static bool ewmh_read_client_list(Window** buf, unsigned long *count) {
@@ -206,6 +238,10 @@ static void ewmh_add_tag_stack(HSTag* tag, void* data) {
 }
 
 void ewmh_update_client_list_stacking() {
+    g_ewmh_dirty |= EWMH_DIRTY_CLIENT_LIST_STACKING;
+}
+
+static void ewmh_write_client_list_stacking() {
     // First: get the windows in the current stack
     struct ewmhstack stack;
     stack.count = g_window_count;
@@ -218,7 +254,7 @@ void ewmh_update_client_list_stacking() {
     tag_foreach(ewmh_add_tag_stack, &stack);
 
     // reverse stacking order, because ewmh requires bottom to top order
-    array_reverse(stack.buf, stack.count, sizeof(stack.buf[0]));
+    array_reverse(stack.buf, stack.i, sizeof(stack.buf[0]));
 
     XChangeProperty(g_display, g_root, g_netatom[NetClientListStacking],
         XA_WINDOW, 32, PropModeReplace,
@@ -226,11 +262,69 @@ void ewmh_update_client_list_stacking() {
     g_free(stack.buf);
 }
 
+static void ewmh_write_desktops() {
+    int cnt = tag_get_count();
+    XChangeProperty(g_display, g_root, g_netatom[NetNumberOfDesktops],
+        XA_CARDINAL, 32, PropModeReplace, (unsigned char*)&cnt, 1);
+}
+
+static void ewmh_write_desktop_names() {
+    char**  names = g_new(char*, tag_get_count());
+    for (int i = 0; i < tag_get_count(); i++) {
+        names[i] = get_tag_by_index(i)->name->str;
+    }
+    XTextProperty text_prop;
+    Xutf8TextListToTextProperty(g_display, names, tag_get_count(),
+                                XUTF8StringStyle, &text_prop);
+    XSetTextProperty(g_display, g_root, &text_prop, g_netatom[NetDesktopNames]);
+    XFree(text_prop.value);
+    g_free(names);
+}
+
+static void ewmh_write_current_desktop() {
+    HSTag* tag = get_current_monitor()->tag;
+    int index = tag_index_of(tag);
+    if (index < 0) {
+        g_warning("tag %s not found in internal list\n", tag->name->str);
+        return;
+    }
+    XChangeProperty(g_display, g_root, g_netatom[NetCurrentDesktop],
+        XA_CARDINAL, 32, PropModeReplace, (unsigned char*)&(index), 1);
+}
+
+void ewmh_flush() {
+    // the properties often are updated multiple times while handling a
+    // single command, so each of them is only written once here
+    int dirty = g_ewmh_dirty;
+    g_ewmh_dirty = 0;
+    ewmh_write_client_list(dirty & EWMH_DIRTY_CLIENT_LIST);
+    if (dirty & EWMH_DIRTY_CLIENT_LIST_STACKING) {
+        ewmh_write_client_list_stacking();
+    }
+    if (dirty & EWMH_DIRTY_DESKTOPS) {
+        ewmh_write_desktops();
+    }
+    if (dirty & EWMH_DIRTY_DESKTOP_NAMES) {
+        ewmh_write_desktop_names();
+    }
+    if (dirty & EWMH_DIRTY_CURRENT_DESKTOP) {
+        ewmh_write_current_desktop();
+    }
+    if (dirty & EWMH_DIRTY_ACTIVE_WINDOW) {
+        XChangeProperty(g_display, g_root, g_netatom[NetActiveWindow],
+            XA_WINDOW, 32, PropModeReplace,
+            (unsigned char*)&(g_active_window), 1);
+    }
+}
+
 void ewmh_add_client(Window win) {
-    g_windows = g_renew(Window, g_windows, g_window_count + 1);
+    if (g_window_count >= g_window_capacity) {
+        g_window_capacity = MAX(16, 2 * g_window_capacity);
+        g_windows = g_renew(Window, g_windows, g_window_capacity);
+    }
     g_windows[g_window_count] = win;
     g_window_count++;
-    ewmh_update_client_list();
+    // the new window is appended to the property on the next flush
     ewmh_update_client_list_stacking();
 }
 
@@ -242,7 +336,6 @@ void ewmh_remove_client(Window win) {
     } else {
         g_memmove(g_windows + index, g_windows + index + 1,
                   sizeof(Window) *(g_window_count - index - 1));
-        g_windows = g_renew(Window, g_windows, g_window_count - 1);
         g_window_count--;
     }
     ewmh_update_client_list();
@@ -250,33 +343,15 @@ void ewmh_remove_client(Window win) {
 }
 
 void ewmh_update_desktops() {
-    int cnt = tag_get_count();
-    XChangeProperty(g_display, g_root, g_netatom[NetNumberOfDesktops],
-        XA_CARDINAL, 32, PropModeReplace, (unsigned char*)&cnt, 1);
+    g_ewmh_dirty |= EWMH_DIRTY_DESKTOPS;
 }
 
 void ewmh_update_desktop_names() {
-    char**  names = g_new(char*, tag_get_count());
-    for (int i = 0; i < tag_get_count(); i++) {
-        names[i] = get_tag_by_index(i)->name->str;
-    }
-    XTextProperty text_prop;
-    Xutf8TextListToTextProperty(g_display, names, tag_get_count(),
-                                XUTF8StringStyle, &text_prop);
-    XSetTextProperty(g_display, g_root, &text_prop, g_netatom[NetDesktopNames]);
-    XFree(text_prop.value);
-    g_free(names);
+    g_ewmh_dirty |= EWMH_DIRTY_DESKTOP_NAMES;
 }
 
 void ewmh_update_current_desktop() {
-    HSTag* tag = get_current_monitor()->tag;
-    int index = tag_index_of(tag);
-    if (index < 0) {
-        g_warning("tag %s not found in internal list\n", tag->name->str);
-        return;
-    }
-    XChangeProperty(g_display, g_root, g_netatom[NetCurrentDesktop],
-        XA_CARDINAL, 32, PropModeReplace, (unsigned char*)&(index), 1);
+    g_ewmh_dirty |= EWMH_DIRTY_CURRENT_DESKTOP;
 }
 
 void ewmh_window_update_tag(Window win, HSTag* tag) {
@@ -290,8 +365,8 @@ void ewmh_window_update_tag(Window win, HSTag* tag) {
 }
 
 void ewmh_update_active_window(Window win) {
-    XChangeProperty(g_display, g_root, g_netatom[NetActiveWindow],
-        XA_WINDOW, 32, PropModeReplace, (unsigned char*)&(win), 1);
+    g_active_window = win;
+    g_ewmh_dirty |= EWMH_DIRTY_ACTIVE_WINDOW;
 }
 
 static bool focus_stealing_allowed(long source) {
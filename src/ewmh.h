@@ -93,7 +93,10 @@ void ewmh_update_wmname();
 
 void ewmh_update_client_list();
 void ewmh_get_original_client_list(Window** buf, unsigned long *count);
+// the ewmh_update_* functions only mark the root window properties as
+// outdated. ewmh_flush() writes them, after handling a batch of events
 void ewmh_update_client_list_stacking();
+void ewmh_flush();
 void ewmh_update_desktops();
 void ewmh_update_desktop_names();
 void ewmh_update_active_window(Window win);
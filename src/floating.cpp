@@ -216,45 +216,253 @@ int find_edge_right_of(RectangleIdx* rects, size_t cnt, int idx) {
 }
 
 
-static int collectclients_helper(HSClient* client, void* data) {
-    GQueue* q = (GQueue*)data;
-    g_queue_push_tail(q, client);
+// the clients of a tag and their geometry, cached for directional focus
+// and shift. For each direction, the clients are sorted by their center and
+// their entry edge, both in the coordinates where that direction becomes
+// "right" (see rectlist_rotate)
+typedef struct {
+    int key;
+    int idx; // index in clients
+} HSFloatingKey;
+
+typedef struct HSFloatingIndex {
+    bool        valid;
+    int         generation; // the tag's layout_generation when it was built
+    GArray*     clients; // of HSClient*, in frame_foreach_client() order
+    GArray*     rects; // of Rectangle, the outer rects of the clients
+    GArray*     centers[4]; // of HSFloatingKey, indexed by enum HSDirection
+    GArray*     edges[4]; // of HSFloatingKey, indexed by enum HSDirection
+} HSFloatingIndex;
+
+// rotates a single rectangle exactly like rectlist_rotate()
+static Rectangle rectangle_rotate(Rectangle r, enum HSDirection dir) {
+    switch (dir) {
+        case DirRight:
+            break;
+        case DirUp:
+            r.y = - r.y - r.height;
+            // fall through
+        case DirDown:
+            SWAP(int, r.x, r.y);
+            SWAP(int, r.height, r.width);
+            break;
+        case DirLeft:
+            r.x = - r.x - r.width;
+            break;
+    }
+    return r;
+}
+
+// whether rectlist_rotate() reverses the order of the rectangles
+static bool direction_reverses(enum HSDirection dir) {
+    return dir == DirUp || dir == DirLeft;
+}
+
+// whether idx a precedes idx b in the rotated order
+static bool rotated_before(int a, int b, enum HSDirection dir) {
+    return direction_reverses(dir) ? (a > b) : (a < b);
+}
+
+static int floating_key_compare(const void* a, const void* b) {
+    const HSFloatingKey* ka = (const HSFloatingKey*)a;
+    const HSFloatingKey* kb = (const HSFloatingKey*)b;
+    if (ka->key != kb->key) {
+        return (ka->key < kb->key) ? -1 : 1;
+    }
+    return ka->idx - kb->idx;
+}
+
+// index of the first key that is greater than key (or equal if inclusive)
+static int floating_keys_bound(GArray* keys, int key, bool inclusive) {
+    int lo = 0, hi = keys->len;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int k = g_array_index(keys, HSFloatingKey, mid).key;
+        if (k < key || (!inclusive && k == key)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int floating_index_add(HSClient* client, void* data) {
+    HSFloatingIndex* index = (HSFloatingIndex*)data;
+    g_array_append_val(index->clients, client);
+    g_array_append_val(index->rects, client->dec.last_outer_rect);
     return 0;
 }
 
+static HSFloatingIndex* floating_index_get(HSTag* tag) {
+    HSFloatingIndex* index = tag->floating_index;
+    if (!index) {
+        index = g_new0(HSFloatingIndex, 1);
+        index->clients = g_array_new(false, false, sizeof(HSClient*));
+        index->rects = g_array_new(false, false, sizeof(Rectangle));
+        for (int dir = 0; dir < LENGTH(index->centers); dir++) {
+            index->centers[dir] = g_array_new(false, false, sizeof(HSFloatingKey));
+            index->edges[dir] = g_array_new(false, false, sizeof(HSFloatingKey));
+        }
+        tag->floating_index = index;
+    }
+    if (index->valid && index->generation == tag->layout_generation) {
+        return index;
+    }
+    g_array_set_size(index->clients, 0);
+    g_array_set_size(index->rects, 0);
+    frame_foreach_client(tag->frame, floating_index_add, index);
+    int cnt = index->rects->len;
+    for (int dir = 0; dir < LENGTH(index->centers); dir++) {
+        g_array_set_size(index->centers[dir], cnt);
+        g_array_set_size(index->edges[dir], cnt);
+        FOR (i,0,cnt) {
+            Rectangle r = rectangle_rotate(
+                g_array_index(index->rects, Rectangle, i), (enum HSDirection)dir);
+            HSFloatingKey center = { r.x + r.width / 2, i };
+            HSFloatingKey edge = { r.x, i };
+            g_array_index(index->centers[dir], HSFloatingKey, i) = center;
+            g_array_index(index->edges[dir], HSFloatingKey, i) = edge;
+        }
+        g_array_sort(index->centers[dir], floating_key_compare);
+        g_array_sort(index->edges[dir], floating_key_compare);
+    }
+    index->valid = true;
+    index->generation = tag->layout_generation;
+    return index;
+}
+
+void floating_index_invalidate(HSTag* tag) {
+    if (tag && tag->floating_index) {
+        tag->floating_index->valid = false;
+    }
+}
+
+void floating_index_destroy(HSFloatingIndex* index) {
+    if (!index) {
+        return;
+    }
+    g_array_free(index->clients, true);
+    g_array_free(index->rects, true);
+    for (int dir = 0; dir < LENGTH(index->centers); dir++) {
+        g_array_free(index->centers[dir], true);
+        g_array_free(index->edges[dir], true);
+    }
+    g_free(index);
+}
+
+// does the same as find_rectangle_in_direction() for the client with index
+// idx, but only looks at clients whose center is not further away than the
+// best one found so far
+static int floating_index_find_rectangle(HSFloatingIndex* index, int idx,
+                                         enum HSDirection dir) {
+    Rectangle RC = rectangle_rotate(
+        g_array_index(index->rects, Rectangle, idx), dir);
+    int cx = RC.x + RC.width / 2;
+    int cy = RC.y + RC.height / 2;
+    GArray* centers = index->centers[dir];
+    int best = -1;
+    int distbest = INT_MAX;
+    for (int k = floating_keys_bound(centers, cx, true); k < centers->len; k++) {
+        HSFloatingKey* key = &g_array_index(centers, HSFloatingKey, k);
+        int rcx = key->key - cx;
+        if (rcx > distbest) {
+            // the manhatten distance is at least rcx
+            break;
+        }
+        int i = key->idx;
+        if (i == idx) continue;
+        Rectangle R2 = rectangle_rotate(
+            g_array_index(index->rects, Rectangle, i), dir);
+        int rcy = R2.y + R2.height / 2 - cy;
+        if (abs(rcy) > rcx) continue;
+        // if two rectangles have exactly the same center, then sort by index
+        if (rcx == 0 && rcy == 0 && rotated_before(i, idx, dir)) continue;
+        int dist = rcx + abs(rcy);
+        if (dist < distbest
+            || (dist == distbest && rotated_before(i, best, dir))) {
+            distbest = dist;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// does the same as find_edge_in_direction() for the client with index idx,
+// where all rectangles are expanded by gap. The edges in extra (which are
+// expanded already) are considered to come after all clients. Returns the
+// index of the found rectangle, where extra[i] has the index cnt + i
+static int floating_index_find_edge(HSFloatingIndex* index, int idx,
+                                    enum HSDirection dir, int gap,
+                                    Rectangle* extra, int extra_cnt) {
+    int cnt = index->rects->len;
+    Rectangle RC = g_array_index(index->rects, Rectangle, idx);
+    RC.x -= gap;
+    RC.y -= gap;
+    RC.width += 2 * gap;
+    RC.height += 2 * gap;
+    RC = rectangle_rotate(RC, dir);
+    int xbound = RC.x + RC.width;
+    int ylow = RC.y;
+    int yhigh = RC.y + RC.height;
+    int found = -1;
+    int dist = INT_MAX;
+    // the expanded edges are gap in front of the keys
+    GArray* edges = index->edges[dir];
+    for (int k = floating_keys_bound(edges, xbound + gap, false); k < edges->len; k++) {
+        HSFloatingKey* key = &g_array_index(edges, HSFloatingKey, k);
+        int d = key->key - gap - xbound;
+        if (d > dist) break;
+        int i = key->idx;
+        if (i == idx) continue;
+        Rectangle R2 = rectangle_rotate(
+            g_array_index(index->rects, Rectangle, i), dir);
+        if (!intervals_intersect(ylow, yhigh,
+                                 R2.y - gap, R2.y + R2.height + gap)) {
+            continue;
+        }
+        if (d < dist || (d == dist && rotated_before(i, found, dir))) {
+            dist = d;
+            found = i;
+        }
+    }
+    FOR (e,0,extra_cnt) {
+        Rectangle R2 = rectangle_rotate(extra[e], dir);
+        int d = R2.x - xbound;
+        if (d <= 0) continue;
+        if (!intervals_intersect(ylow, yhigh, R2.y, R2.y + R2.height)) {
+            continue;
+        }
+        if (d < dist || (d == dist && rotated_before(cnt + e, found, dir))) {
+            dist = d;
+            found = cnt + e;
+        }
+    }
+    return found;
+}
+
 bool floating_focus_direction(enum HSDirection dir) {
     if (*g_monitors_locked) { return false; }
     HSTag* tag = g_cur_frame->tag;
-    GQueue* q = g_queue_new();
-    frame_foreach_client(tag->frame, collectclients_helper, q);
-    int cnt = q->length;
-    RectangleIdx* rects = g_new0(RectangleIdx, cnt);
-    int i = 0;
-    int curfocusidx = -1;
+    HSFloatingIndex* index = floating_index_get(tag);
     HSClient* curfocus = get_current_client();
-    bool success = true;
-    if (curfocus == NULL && cnt == 0) {
-        success = false;
-    }
-    for (GList* cur = q->head; cur != NULL; cur = cur->next, i++) {
-        HSClient* client = (HSClient*)cur->data;
-        if (curfocus == client) curfocusidx = i;
-        rects[i].idx = i;
-        rects[i].r = client->dec.last_outer_rect;
+    int curfocusidx = -1;
+    FOR (i,0,index->clients->len) {
+        if (g_array_index(index->clients, HSClient*, i) == curfocus) {
+            curfocusidx = i;
+            break;
+        }
     }
-    int idx = (cnt > 0)
-              ? find_rectangle_in_direction(rects, cnt, curfocusidx, dir)
+    int idx = (curfocusidx >= 0)
+              ? floating_index_find_rectangle(index, curfocusidx, dir)
               : -1;
     if (idx < 0) {
-        success = false;
-    } else {
-        HSClient* client = (HSClient*)g_queue_peek_nth(q, idx);
-        client_raise(client);
-        focus_client(client, false, false);
+        return false;
     }
-    g_free(rects);
-    g_queue_free(q);
-    return success;
+    HSClient* client = g_array_index(index->clients, HSClient*, idx);
+    client_raise(client);
+    focus_client(client, false, false);
+    return true;
 }
 
 bool floating_shift_direction(enum HSDirection dir) {
@@ -262,69 +470,62 @@ bool floating_shift_direction(enum HSDirection dir) {
     HSTag* tag = g_cur_frame->tag;
     HSClient* curfocus = get_current_client();
     if (!curfocus) return false;
-    GQueue* q = g_queue_new();
-    frame_foreach_client(tag->frame, collectclients_helper, q);
-    int cnt = q->length;
-    if (cnt == 0) {
-        g_queue_free(q);
-        return false;
-    }
-    RectangleIdx* rects = g_new0(RectangleIdx, cnt + 4);
-    int i = 0;
+    HSFloatingIndex* index = floating_index_get(tag);
+    int cnt = index->clients->len;
     int curfocusidx = -1;
-    bool success = true;
-    for (GList* cur = q->head; cur != NULL; cur = cur->next, i++) {
-        HSClient* client = (HSClient*)cur->data;
-        if (curfocus == client) curfocusidx = i;
-        rects[i].idx = i;
-        rects[i].r = client->dec.last_outer_rect;
-    }
-    g_queue_free(q);
-    // add artifical rects for screen edges
-    {
-        Rectangle mr = monitor_get_floating_area(get_current_monitor());
-        Rectangle tmp[4] = {
-            { mr.x, mr.y,               mr.width, 0 }, // top
-            { mr.x, mr.y,               0, mr.height }, // left
-            { mr.x + mr.width, mr.y,    0, mr.height }, // right
-            { mr.x, mr.y + mr.height,   mr.y + mr.width, 0 }, // bottom
-        };
-        FOR (i,0,4) {
-            rects[cnt + i].idx = -1;
-            rects[cnt + i].r = tmp[i];
+    FOR (i,0,cnt) {
+        if (g_array_index(index->clients, HSClient*, i) == curfocus) {
+            curfocusidx = i;
+            break;
         }
     }
-    FOR (i,0, cnt + 4) {
+    if (curfocusidx < 0) {
+        return false;
+    }
+    // add artifical rects for screen edges
+    Rectangle mr = monitor_get_floating_area(get_current_monitor());
+    Rectangle edges[4] = {
+        { mr.x, mr.y,               mr.width, 0 }, // top
+        { mr.x, mr.y,               0, mr.height }, // left
+        { mr.x + mr.width, mr.y,    0, mr.height }, // right
+        { mr.x, mr.y + mr.height,   mr.y + mr.width, 0 }, // bottom
+    };
+    FOR (i,0,4) {
         // expand anything by the snap gap
-        rects[i].r.x -= *g_snap_gap;
-        rects[i].r.y -= *g_snap_gap;
-        rects[i].r.width += 2 * *g_snap_gap;
-        rects[i].r.height += 2 * *g_snap_gap;
+        edges[i].x -= *g_snap_gap;
+        edges[i].y -= *g_snap_gap;
+        edges[i].width += 2 * *g_snap_gap;
+        edges[i].height += 2 * *g_snap_gap;
     }
     // don't apply snapgap to focused client, so there will be exactly
     // *g_snap_gap pixels between the focused client and the found edge
     Rectangle focusrect = curfocus->dec.last_outer_rect;
-    int idx = find_edge_in_direction(rects, cnt + 4, curfocusidx, dir);
-    if (idx < 0) success = false;
-    else {
-        // shift client
-        int dx = 0, dy = 0;
-        Rectangle r = rects[idx].r;
-        //printf("edge: %dx%d at %d,%d\n", r.width, r.height, r.x, r.y);
-        //printf("focus: %dx%d at %d,%d\n", focusrect.width, focusrect.height, focusrect.x, focusrect.y);
-        switch (dir) {
-            //          delta = new edge  -  old edge
-            case DirRight: dx = r.x  -   (focusrect.x + focusrect.width); break;
-            case DirLeft:  dx = r.x + r.width   -   focusrect.x; break;
-            case DirDown:  dy = r.y  -  (focusrect.y + focusrect.height); break;
-            case DirUp:    dy = r.y + r.height  -  focusrect.y; break;
-        }
-        //printf("dx=%d, dy=%d\n", dx, dy);
-        curfocus->float_size.x += dx;
-        curfocus->float_size.y += dy;
-        monitor_apply_layout(get_current_monitor());
+    int idx = floating_index_find_edge(index, curfocusidx, dir, *g_snap_gap,
+                                       edges, LENGTH(edges));
+    if (idx < 0) {
+        return false;
+    }
+    Rectangle r;
+    if (idx < cnt) {
+        r = g_array_index(index->rects, Rectangle, idx);
+        r.x -= *g_snap_gap;
+        r.y -= *g_snap_gap;
+        r.width += 2 * *g_snap_gap;
+        r.height += 2 * *g_snap_gap;
+    } else {
+        r = edges[idx - cnt];
+    }
+    // shift client
+    int dx = 0, dy = 0;
+    switch (dir) {
+        //          delta = new edge  -  old edge
+        case DirRight: dx = r.x  -   (focusrect.x + focusrect.width); break;
+        case DirLeft:  dx = r.x + r.width   -   focusrect.x; break;
+        case DirDown:  dy = r.y  -  (focusrect.y + focusrect.height); break;
+        case DirUp:    dy = r.y + r.height  -  focusrect.y; break;
     }
-    g_free(rects);
-    return success;
+    curfocus->float_size.x += dx;
+    curfocus->float_size.y += dy;
+    monitor_apply_layout(get_current_monitor());
+    return true;
 }
-
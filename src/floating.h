@@ -35,6 +35,12 @@ int find_edge_in_direction(RectangleIdx* rects, size_t cnt, int idx,
                                 enum HSDirection dir);
 int find_edge_right_of(RectangleIdx* rects, size_t cnt, int idx);
 
+struct HSTag;
+struct HSFloatingIndex;
+// called if the geometry of a client on tag changes
+void floating_index_invalidate(struct HSTag* tag);
+void floating_index_destroy(struct HSFloatingIndex* index);
+
 // actual implementations
 bool floating_focus_direction(enum HSDirection dir);
 bool floating_shift_direction(enum HSDirection dir);
@@ -8,6 +8,7 @@
 #include "utils.h"
 #include "ipc-protocol.h"
 #include "ipc-server.h"
+#include "ewmh.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -50,6 +51,9 @@ bool ipc_handle_connection(Window win) {
     }
     GString* output = g_string_new("");
     int status = call_command(count, list_return, output);
+    // the client may read the root window properties right after the reply,
+    // so write what the command changed before
+    ewmh_flush();
     // send output back
     // Mark this command as executed
     XDeleteProperty(g_display, win, ATOM(HERBST_IPC_ARGS_ATOM));
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdint.h>
+#include <ctype.h>
 
 #include <memory>
 
@@ -59,6 +60,12 @@ HSFrame*    g_cur_frame; // currently selected frame
 int* g_frame_gap;
 int* g_window_gap;
 
+// incremented whenever the frame colors or borders are changed, such that
+// the frame window state applied before is invalid
+static int g_frame_style_generation = 0;
+
+static void frame_index_invalidate(HSTag* tag);
+
 const char* g_align_names[] = {
     "vertical",
     "horizontal",
@@ -109,6 +116,7 @@ void layout_init() {
 }
 void reset_frame_colors() {
     fetch_frame_colors();
+    g_frame_style_generation++;
     all_monitors_apply_layout();
 }
 
@@ -116,16 +124,72 @@ void layout_destroy() {
 }
 
 
+/* frame pool
+ * the frames of a tag are allocated in chunks of FRAME_POOL_CHUNK_SIZE
+ * frames. Unused frames are kept in a free list, which is linked via the
+ * parent pointer.
+ */
+#define FRAME_POOL_CHUNK_SIZE 16
+
+typedef struct HSFrameChunk {
+    struct HSFrameChunk* next;
+    HSFrame frames[FRAME_POOL_CHUNK_SIZE];
+} HSFrameChunk;
+
+typedef struct HSFramePool {
+    HSFrameChunk*   chunks;
+    HSFrame*        free_list;
+} HSFramePool;
+
+HSFramePool* frame_pool_create() {
+    return g_new0(HSFramePool, 1);
+}
+
+void frame_pool_destroy(HSFramePool* pool) {
+    HSFrameChunk* chunk = pool->chunks;
+    while (chunk) {
+        HSFrameChunk* next = chunk->next;
+        g_free(chunk);
+        chunk = next;
+    }
+    g_free(pool);
+}
+
+static HSFrame* frame_pool_alloc(HSFramePool* pool) {
+    if (!pool->free_list) {
+        HSFrameChunk* chunk = g_new(HSFrameChunk, 1);
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        for (int i = 0; i < FRAME_POOL_CHUNK_SIZE; i++) {
+            chunk->frames[i].parent = pool->free_list;
+            pool->free_list = chunk->frames + i;
+        }
+    }
+    HSFrame* frame = pool->free_list;
+    pool->free_list = frame->parent;
+    memset((void*)frame, 0, sizeof(*frame));
+    return frame;
+}
+
+static void frame_pool_free(HSFramePool* pool, HSFrame* frame) {
+    frame->parent = pool->free_list;
+    pool->free_list = frame;
+}
+
 /* create a new frame
  * you can either specify a frame or a tag as its parent
  */
 HSFrame* frame_create_empty(HSFrame* parent, HSTag* parenttag) {
-    HSFrame* frame = g_new0(HSFrame, 1);
+    HSTag* tag = parent ? parent->tag : parenttag;
+    HSFrame* frame = frame_pool_alloc(tag->frame_pool);
     frame->type = TYPE_CLIENTS;
     frame->window_visible = false;
+    frame->dirty = true;
     frame->content.clients.layout = *g_default_frame_layout;
     frame->parent = parent;
-    frame->tag = parent ? parent->tag : parenttag;
+    frame->tag = tag;
+    frame->content.clients.buf = frame->inline_clients;
+    frame_index_invalidate(tag);
     // set window attributes
     XSetWindowAttributes at;
     at.background_pixel  = getcolor("red");
@@ -135,6 +199,9 @@ HSFrame* frame_create_empty(HSFrame* parent, HSTag* parenttag) {
     at.event_mask        = SubstructureRedirectMask|SubstructureNotifyMask
          |ExposureMask|VisibilityChangeMask
          |EnterWindowMask|LeaveWindowMask|FocusChangeMask;
+    frame->applied.window_rect = Rectangle(42, 42, 42, 42);
+    frame->applied.border_width = *g_frame_border_width;
+    frame->applied_style = -1;
     frame->window = XCreateWindow(g_display, g_root,
                         42, 42, 42, 42, *g_frame_border_width,
                         DefaultDepth(g_display, DefaultScreen(g_display)),
@@ -153,6 +220,49 @@ HSFrame* frame_create_empty(HSFrame* parent, HSTag* parenttag) {
     return frame;
 }
 
+// resizes the client buf of a client frame to count entries, keeping the
+// first entries. Small bufs are stored within the frame itself.
+static HSClient** frame_resize_client_buf(HSFrame* frame, size_t count) {
+    HSClient** buf = frame->content.clients.buf;
+    size_t old_count = frame->content.clients.count;
+    bool is_inline = (buf == frame->inline_clients);
+    if (count <= FRAME_INLINE_CLIENTS) {
+        if (!is_inline) {
+            memcpy(frame->inline_clients, buf,
+                   sizeof(buf[0]) * MIN(count, old_count));
+            g_free(buf);
+            buf = frame->inline_clients;
+        }
+    } else if (is_inline) {
+        buf = g_new(HSClient*, count);
+        memcpy(buf, frame->inline_clients, sizeof(buf[0]) * old_count);
+    } else {
+        buf = g_renew(HSClient*, buf, count);
+    }
+    frame->content.clients.buf = buf;
+    return buf;
+}
+
+// makes the client buf point to the frame's own inline storage again, e.g.
+// after the content was copied from another frame
+static void frame_fix_inline_clients(HSFrame* frame, HSFrame* source) {
+    if (frame->content.clients.buf == source->inline_clients) {
+        memcpy(frame->inline_clients, source->inline_clients,
+               sizeof(frame->inline_clients));
+        frame->content.clients.buf = frame->inline_clients;
+    }
+}
+
+// updates the frame back-pointers of the clients in buf[from..count-1]
+static void frame_update_client_pointers(HSFrame* frame, size_t from) {
+    HSClient** buf = frame->content.clients.buf;
+    size_t count = frame->content.clients.count;
+    for (size_t i = from; i < count; i++) {
+        buf[i]->frame = frame;
+        buf[i]->frame_index = i;
+    }
+}
+
 void frame_insert_client(HSFrame* frame, struct HSClient* client) {
     if (frame->type == TYPE_CLIENTS) {
         // insert it here
@@ -163,13 +273,15 @@ void frame_insert_client(HSFrame* frame, struct HSClient* client) {
         // insert it after the selection
         int index = frame->content.clients.selection + 1;
         index = CLAMP(index, 0, count - 1);
-        buf = g_renew(HSClient*, buf, count);
+        buf = frame_resize_client_buf(frame, count);
         // shift other windows to the back to insert the new one at index
         memmove(buf + index + 1, buf + index, sizeof(*buf) * (count - index - 1));
         buf[index] = client;
         // write results back
         frame->content.clients.count = count;
         frame->content.clients.buf = buf;
+        frame_update_client_pointers(frame, index);
+        frame_set_dirty(frame);
         // check for focus
         if (g_cur_frame == frame
             && frame->content.clients.selection >= (count-1)) {
@@ -209,62 +321,52 @@ HSFrame* lookup_frame(HSFrame* root, const char *index) {
 }
 
 HSFrame* find_frame_with_client(HSFrame* frame, struct HSClient* client) {
-    if (frame->type == TYPE_CLIENTS) {
-        HSClient** buf = frame->content.clients.buf;
-        size_t count = frame->content.clients.count;
-        for (int i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                return frame;
-            }
+    // check that the client's frame is a subframe of frame
+    for (HSFrame* f = client->frame; f; f = f->parent) {
+        if (f == frame) {
+            return client->frame;
         }
-        return NULL;
-    } else { /* frame->type == TYPE_FRAMES */
-        HSFrame* found = find_frame_with_client(frame->content.layout.a, client);
-        if (!found) {
-            found = find_frame_with_client(frame->content.layout.b, client);
-        }
-        return found;
     }
+    return NULL;
 }
 
 bool frame_remove_client(HSFrame* frame, HSClient* client) {
-    if (frame->type == TYPE_CLIENTS) {
-        HSClient** buf = frame->content.clients.buf;
-        size_t count = frame->content.clients.count;
-        int i;
-        for (i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                // if window was found
-                // them remove it
-                memmove(buf+i, buf+i+1, sizeof(buf[0])*(count - i - 1));
-                count--;
-                buf = g_renew(HSClient*, buf, count);
-                frame->content.clients.buf = buf;
-                frame->content.clients.count = count;
-                // find out new selection
-                int selection = frame->content.clients.selection;
-                // if selection was before removed window
-                // then do nothing
-                // else shift it by 1
-                selection -= (selection < i) ? 0 : 1;
-                // ensure, that it's a valid index
-                selection = count ? CLAMP(selection, 0, ((int)count)-1) : 0;
-                frame->content.clients.selection = selection;
-                return true;
-            }
-        }
+    frame = find_frame_with_client(frame, client);
+    if (!frame) {
         return false;
-    } else { /* frame->type == TYPE_FRAMES */
-        bool found = frame_remove_client(frame->content.layout.a, client);
-        found = found || frame_remove_client(frame->content.layout.b, client);
-        return found;
     }
+    HSClient** buf = frame->content.clients.buf;
+    size_t count = frame->content.clients.count;
+    int i = client->frame_index;
+    HSAssert(i < count && buf[i] == client);
+    memmove(buf+i, buf+i+1, sizeof(buf[0])*(count - i - 1));
+    count--;
+    frame_resize_client_buf(frame, count);
+    frame->content.clients.count = count;
+    // find out new selection
+    int selection = frame->content.clients.selection;
+    // if selection was before removed window
+    // then do nothing
+    // else shift it by 1
+    selection -= (selection < i) ? 0 : 1;
+    // ensure, that it's a valid index
+    selection = count ? CLAMP(selection, 0, ((int)count)-1) : 0;
+    frame->content.clients.selection = selection;
+    client->frame = NULL;
+    frame_update_client_pointers(frame, i);
+    frame_set_dirty(frame);
+    return true;
 }
 
 void frame_destroy(HSFrame* frame, HSClient*** buf, size_t* count) {
     if (frame->type == TYPE_CLIENTS) {
         *buf = frame->content.clients.buf;
         *count = frame->content.clients.count;
+        if (*buf == frame->inline_clients) {
+            // the caller gets a buf on the heap
+            *buf = g_new(HSClient*, *count);
+            memcpy(*buf, frame->inline_clients, sizeof(**buf) * *count);
+        }
     } else { /* frame->type == TYPE_FRAMES */
         size_t c1, c2;
         HSClient **buf1, **buf2;
@@ -281,9 +383,14 @@ void frame_destroy(HSFrame* frame, HSClient*** buf, size_t* count) {
     }
     stack_remove_slice(frame->tag->stack, frame->slice);
     slice_destroy(frame->slice);
+    frame_index_invalidate(frame->tag);
+    if (g_cur_frame == frame) {
+        // do not leave a dangling pointer
+        g_cur_frame = NULL;
+    }
     // free other things
     XDestroyWindow(g_display, frame->window);
-    g_free(frame);
+    frame_pool_free(frame->tag->frame_pool, frame);
 }
 
 void dump_frame_tree(HSFrame* frame, GString* output) {
@@ -319,112 +426,335 @@ void dump_frame_tree(HSFrame* frame, GString* output) {
     }
 }
 
-char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg) {
-    // find next (
-    description = strchr(description, LAYOUT_DUMP_BRACKETS[0]);
-    if (!description) {
-        g_string_append_printf(errormsg, "Missing %c\n",
-            LAYOUT_DUMP_BRACKETS[0]);
-        return NULL;
+/* a frame of a parsed layout description
+ * The nodes are stored in an array and refer to their children and windows
+ * by index. Nothing of the description is copied except the parsed values.
+ */
+typedef struct HSLayoutNode {
+    int     type; // TYPE_CLIENTS or TYPE_FRAMES
+    int     selection;
+    union {
+        struct {
+            int     align;
+            int     fraction;
+            size_t  a, b; // indices of the children
+        } split;
+        struct {
+            int     layout;
+            size_t  first_window; // index in the window array
+            size_t  window_count;
+        } clients;
+    };
+} HSLayoutNode;
+
+typedef struct HSLayoutParser {
+    const char* input;
+    size_t      pos;
+    GArray*     nodes;      // of HSLayoutNode
+    GArray*     windows;    // of Window
+    int         splits[2];  // count of splits per align above current node
+    GString*    errormsg;
+} HSLayoutParser;
+
+static bool layout_parse_error(HSLayoutParser* p, size_t offset,
+                               const char* message) {
+    g_string_append_printf(p->errormsg, "Syntax error at byte %zu: %s\n",
+                           offset, message);
+    return false;
+}
+
+// jumps over the character c, which must be at the current position
+static bool layout_parse_char(HSLayoutParser* p, char c) {
+    if (p->input[p->pos] != c) {
+        g_string_append_printf(p->errormsg,
+            "Syntax error at byte %zu: Missing %c\n", p->pos, c);
+        return false;
     }
-    description++; // jump over (
-
-    // goto frame type
-    description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-    int type = TYPE_CLIENTS;
-    if (description[0] == 's') {
-        // if it could be "split"
-        type = TYPE_FRAMES;
-    }
-
-    // get substring with frame args
-    // jump to whitespaces and over them
-    description += strcspn(description, LAYOUT_DUMP_WHITESPACES);
-    description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-    // jump to whitespaces or brackets
-    size_t args_len = strcspn(description, LAYOUT_DUMP_WHITESPACES LAYOUT_DUMP_BRACKETS);
-    char* args = new char[args_len + 1];
-    std::unique_ptr<char> free_args_correctly (args);
-    strncpy(args, description, args_len);
-    args[args_len] = '\0';
-    // jump over args substring
-    description += args_len;
-    if (!*description) {
-        g_string_append_printf(errormsg, "Missing %c or arguments\n", LAYOUT_DUMP_BRACKETS[1]);
-        return NULL;
+    p->pos++;
+    return true;
+}
+
+static void layout_parse_whitespaces(HSLayoutParser* p) {
+    p->pos += strspn(p->input + p->pos, LAYOUT_DUMP_WHITESPACES);
+}
+
+// returns the length of the word at the current position
+static size_t layout_parse_word(HSLayoutParser* p) {
+    return strcspn(p->input + p->pos, LAYOUT_DUMP_WHITESPACES
+                                      LAYOUT_DUMP_BRACKETS
+                                      LAYOUT_DUMP_SEPARATOR_STR);
+}
+
+// parses the next word as one of the names and returns its index or -1
+static int layout_parse_name(HSLayoutParser* p, const char** names,
+                             size_t count) {
+    size_t len = layout_parse_word(p);
+    for (int i = 0; i < count && names[i]; i++) {
+        if (strlen(names[i]) == len
+            && !strncmp(p->input + p->pos, names[i], len)) {
+            p->pos += len;
+            return i;
+        }
     }
-    description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-    if (!*description) {
-        g_string_append_printf(errormsg, "Missing %c or arguments\n", LAYOUT_DUMP_BRACKETS[1]);
-        return NULL;
+    return -1;
+}
+
+// whether a number or word may end at the current position
+static bool layout_parse_at_token_end(HSLayoutParser* p) {
+    char c = p->input[p->pos];
+    return c == LAYOUT_DUMP_BRACKETS[1]
+           || (c != '\0' && strchr(LAYOUT_DUMP_WHITESPACES, c));
+}
+
+static bool layout_parse_int(HSLayoutParser* p, int* value) {
+    const char* start = p->input + p->pos;
+    char* end = (char*)start;
+    // strtol() would also skip leading whitespace
+    if (isdigit((unsigned char)*start)
+        || (*start == '-' && isdigit((unsigned char)start[1]))) {
+        *value = (int)strtol(start, &end, 10);
+    }
+    if (end == start) {
+        return layout_parse_error(p, p->pos, "Invalid selection");
+    }
+    p->pos += end - start;
+    return true;
+}
+
+static bool layout_parse_split_args(HSLayoutParser* p, HSLayoutNode* node) {
+    node->split.align = layout_parse_name(p, g_align_names,
+                                          LENGTH(g_align_names));
+    if (node->split.align < 0) {
+        return layout_parse_error(p, p->pos, "Invalid alignment name");
+    }
+    if (!layout_parse_char(p, LAYOUT_DUMP_SEPARATOR)) {
+        return false;
+    }
+    const char* start = p->input + p->pos;
+    char* end;
+    double fraction = strtod(start, &end);
+    if (end == start) {
+        return layout_parse_error(p, p->pos, "Invalid fraction");
+    }
+    p->pos += end - start;
+    // the same range as in frame_split()
+    node->split.fraction = CLAMP((int)(fraction * (double)FRACTION_UNIT),
+                                 FRACTION_UNIT * (0.0 + FRAME_MIN_FRACTION),
+                                 FRACTION_UNIT * (1.0 - FRAME_MIN_FRACTION));
+    if (!layout_parse_char(p, LAYOUT_DUMP_SEPARATOR)
+        || !layout_parse_int(p, &node->selection)) {
+        return false;
     }
+    node->selection = !!node->selection; // CLAMP it to [0;1]
+    return true;
+}
 
-    // apply type to frame
-    if (type == TYPE_FRAMES) {
-        // parse args
-        char* align_name = g_new(char, strlen(args)+1);
-        int selection;
-        double fraction_double;
-#define SEP LAYOUT_DUMP_SEPARATOR_STR
-        if (3 != sscanf(args, "%[^" SEP "]" SEP "%lf" SEP "%d",
-            align_name, &fraction_double, &selection)) {
-            g_string_append_printf(errormsg,
-                "Can not parse frame args \"%s\"\n", args);
-            return NULL;
+static bool layout_parse_clients_args(HSLayoutParser* p, HSLayoutNode* node) {
+    node->clients.layout = layout_parse_name(p, g_layout_names,
+                                             LENGTH(g_layout_names));
+    if (node->clients.layout < 0) {
+        return layout_parse_error(p, p->pos, "Invalid layout name");
+    }
+    return layout_parse_char(p, LAYOUT_DUMP_SEPARATOR)
+           && layout_parse_int(p, &node->selection);
+}
+
+static bool layout_parse_windows(HSLayoutParser* p, HSLayoutNode* node) {
+    node->clients.first_window = p->windows->len;
+    layout_parse_whitespaces(p);
+    while (p->input[p->pos] != LAYOUT_DUMP_BRACKETS[1]
+           && p->input[p->pos] != '\0') {
+        size_t offset = p->pos;
+        const char* start = p->input + p->pos;
+        char* end = (char*)start;
+        Window win = 0;
+        // strtoul() would also accept a sign, e.g. wrap -1 around
+        if (isxdigit((unsigned char)*start)) {
+            win = strtoul(start, &end, 16);
         }
-#undef SEP
-        int align = find_align_by_name(align_name);
-        g_free(align_name);
-        if (align < 0) {
-            g_string_append_printf(errormsg,
-                "Invalid alignment name in args \"%s\"\n", args);
-            return NULL;
+        p->pos += end - start;
+        if (end == start || !layout_parse_at_token_end(p)) {
+            return layout_parse_error(p, offset, "Invalid window id");
         }
-        selection = !!selection; // CLAMP it to [0;1]
-        int fraction = (int)(fraction_double * (double)FRACTION_UNIT);
+        g_array_append_val(p->windows, win);
+        layout_parse_whitespaces(p);
+    }
+    node->clients.window_count = p->windows->len - node->clients.first_window;
+    return true;
+}
 
-        // ensure that it is split
-        if (frame->type == TYPE_FRAMES) {
-            // nothing to do
-            frame->content.layout.align = align;
-            frame->content.layout.fraction = fraction;
-        } else {
-            frame_split(frame, align, fraction);
-            if (frame->type != TYPE_FRAMES) {
-                g_string_append_printf(errormsg,
-                    "Can not split frame\n");
-                return NULL;
+// parses the frame at the current position and appends it and its subframes
+// to the node array. The index of the frame is stored in index.
+static bool layout_parse_frame(HSLayoutParser* p, size_t* index) {
+    layout_parse_whitespaces(p);
+    size_t frame_offset = p->pos;
+    if (!layout_parse_char(p, LAYOUT_DUMP_BRACKETS[0])) {
+        return false;
+    }
+    layout_parse_whitespaces(p);
+    HSLayoutNode node;
+    memset(&node, 0, sizeof(node));
+    size_t len = layout_parse_word(p);
+    const char* type = p->input + p->pos;
+    if (len == strlen("split") && !strncmp(type, "split", len)) {
+        node.type = TYPE_FRAMES;
+    } else if (len == strlen("clients") && !strncmp(type, "clients", len)) {
+        node.type = TYPE_CLIENTS;
+    } else {
+        return layout_parse_error(p, p->pos, "Invalid frame type");
+    }
+    p->pos += len;
+    layout_parse_whitespaces(p);
+    size_t args_offset = p->pos;
+    if (node.type == TYPE_FRAMES) {
+        if (!layout_parse_split_args(p, &node)) {
+            return false;
+        }
+        // frame_split() would refuse to split that deep
+        if (p->splits[node.split.align] > HERBST_MAX_TREE_HEIGHT) {
+            return layout_parse_error(p, frame_offset, "Too many splits");
+        }
+    } else if (!layout_parse_clients_args(p, &node)) {
+        return false;
+    }
+    if (!layout_parse_at_token_end(p)) {
+        return layout_parse_error(p, args_offset, "Invalid frame arguments");
+    }
+    *index = p->nodes->len;
+    if (node.type == TYPE_FRAMES) {
+        g_array_append_val(p->nodes, node);
+        size_t a, b;
+        p->splits[node.split.align]++;
+        if (!layout_parse_frame(p, &a) || !layout_parse_frame(p, &b)) {
+            return false;
+        }
+        p->splits[node.split.align]--;
+        HSLayoutNode* n = &g_array_index(p->nodes, HSLayoutNode, *index);
+        n->split.a = a;
+        n->split.b = b;
+        layout_parse_whitespaces(p);
+    } else {
+        if (!layout_parse_windows(p, &node)) {
+            return false;
+        }
+        g_array_append_val(p->nodes, node);
+    }
+    return layout_parse_char(p, LAYOUT_DUMP_BRACKETS[1]);
+}
+
+// moves the windows of a clients node to frame, which already is a client
+// frame. Windows that already are in this frame only are reordered.
+static void load_frame_clients(HSFrame* frame, HSLayoutParser* p,
+                               HSLayoutNode* node) {
+    HSTag* tag = frame->tag;
+    int index = 0;
+    for (size_t i = 0; i < node->clients.window_count; i++) {
+        Window win = g_array_index(p->windows, Window,
+                                   node->clients.first_window + i);
+        HSClient* client = get_client_from_window(win);
+        if (!client) {
+            // client not managed... ignore it
+            continue;
+        }
+        if (client->frame == frame) {
+            // the window already is in this frame, so only move it to
+            // the right position
+            HSClient** buf = frame->content.clients.buf;
+            int count = frame->content.clients.count;
+            int old = client->frame_index;
+            index = CLAMP(index, 0, count - 1);
+            if (old > index) {
+                memmove(buf + index + 1, buf + index,
+                        sizeof(buf[0]) * (old - index));
+            } else if (old < index) {
+                memmove(buf + old, buf + old + 1,
+                        sizeof(buf[0]) * (index - old));
             }
+            if (old != index) {
+                buf[index] = client;
+                frame_update_client_pointers(frame, MIN(old, index));
+                frame_set_dirty(frame);
+            }
+            index++;
+            continue;
         }
-        frame->content.layout.selection = selection;
 
-        // now parse subframes
-        description = load_frame_tree(frame->content.layout.a,
-                        description, errormsg);
-        if (!description) return NULL;
-        description = load_frame_tree(frame->content.layout.b,
-                        description, errormsg);
-        if (!description) return NULL;
-    } else {
-        // parse args
-        char* layout_name = g_new(char, strlen(args)+1);
-        int selection;
-#define SEP LAYOUT_DUMP_SEPARATOR_STR
-        if (2 != sscanf(args, "%[^" SEP "]" SEP "%d",
-            layout_name, &selection)) {
-            g_string_append_printf(errormsg,
-                "Can not parse frame args \"%s\"\n", args);
-            return NULL;
+        // remove window from old frame
+        HSTag* oldtag = client->tag;
+        if (!frame_remove_client(oldtag->frame, client)) {
+            g_warning("window %lx was not found on tag %s\n",
+                win, oldtag->name->str);
         }
-#undef SEP
-        int layout = find_layout_by_name(layout_name);
-        g_free(layout_name);
-        if (layout < 0) {
-            g_string_append_printf(errormsg,
-                "Can not parse layout from args \"%s\"\n", args);
-            return NULL;
+        if (oldtag != tag) {
+            // the layout of this tag is applied by the caller, other
+            // tags need to be updated here
+            HSMonitor* clientmonitor = find_monitor_with_tag(oldtag);
+            if (clientmonitor) {
+                monitor_apply_layout(clientmonitor);
+            }
+            stack_remove_slice(oldtag->stack, client->slice);
+        }
+
+        // insert it to buf
+        HSClient** buf = frame->content.clients.buf;
+        size_t count = frame->content.clients.count;
+        count++;
+        index = CLAMP(index, 0, count - 1);
+        buf = frame_resize_client_buf(frame, count);
+        memmove(buf + index + 1, buf + index,
+                sizeof(buf[0]) * (count - index - 1));
+        buf[index] = client;
+        frame->content.clients.count = count;
+        frame_update_client_pointers(frame, index);
+        frame_set_dirty(frame);
+
+        if (oldtag != tag) {
+            client->tag = tag;
+            stack_insert_slice(client->tag->stack, client->slice);
+            ewmh_window_update_tag(client->window, client->tag);
+        }
+
+        index++;
+    }
+    // apply layout and selection
+    int selection = node->selection;
+    selection = (selection < frame->content.clients.count) ? selection : 0;
+    selection = (selection >= 0) ? selection : 0;
+    if (frame->content.clients.layout != node->clients.layout
+        || frame->content.clients.selection != selection) {
+        frame_set_dirty(frame);
+    }
+    frame->content.clients.layout = node->clients.layout;
+    frame->content.clients.selection = selection;
+}
+
+// applies the parsed node to frame
+static void load_frame_node(HSFrame* frame, HSLayoutParser* p, size_t index) {
+    HSLayoutNode* node = &g_array_index(p->nodes, HSLayoutNode, index);
+    if (node->type == TYPE_FRAMES) {
+        // ensure that it is split
+        if (frame->type == TYPE_FRAMES) {
+            // reuse the existing split
+            HSLayout* old = &frame->content.layout;
+            if (old->align != node->split.align
+                || old->fraction != node->split.fraction
+                || old->selection != node->selection) {
+                frame_set_dirty(frame);
+            }
+            frame->content.layout.align = node->split.align;
+            frame->content.layout.fraction = node->split.fraction;
+        } else {
+            // the tree height already was checked while parsing
+            bool split = frame_split(frame, node->split.align,
+                                     node->split.fraction);
+            HSAssert(split);
         }
+        frame->content.layout.selection = node->selection;
 
+        // now apply subframes
+        load_frame_node(frame->content.layout.a, p, node->split.a);
+        load_frame_node(frame->content.layout.b, p, node->split.b);
+    } else {
         // ensure that it is a client frame
         if (frame->type == TYPE_FRAMES) {
             // remove childs
@@ -447,75 +777,57 @@ char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg) {
             frame->content.clients.count = count;
             frame->content.clients.selection = 0; // only some sane defaults
             frame->content.clients.layout = 0; // only some sane defaults
+            frame_update_client_pointers(frame, 0);
+            frame_set_dirty(frame);
         }
+        load_frame_clients(frame, p, node);
+    }
+}
 
-        // bring child wins
-        // jump over whitespaces
-        description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-        int index = 0;
-        HSTag* tag = find_tag_with_toplevel_frame(get_toplevel_frame(frame));
-        while (*description != LAYOUT_DUMP_BRACKETS[1]) {
-            Window win;
-            if (1 != sscanf(description, "0x%lx\n", &win)) {
-                g_string_append_printf(errormsg,
-                    "Can not parse window id from \"%s\"\n", description);
-                return NULL;
-            }
-            // jump over window id and over whitespaces
-            description += strspn(description, "0x123456789abcdef");
-            description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-
-            // bring window here
-            HSClient* client = get_client_from_window(win);
-            if (!client) {
-                // client not managed... ignore it
-                continue;
-            }
-
-            // remove window from old tag
-            HSMonitor* clientmonitor = find_monitor_with_tag(client->tag);
-            if (!frame_remove_client(client->tag->frame, client)) {
-                g_warning("window %lx was not found on tag %s\n",
-                    win, client->tag->name->str);
-            }
-            if (clientmonitor) {
-                monitor_apply_layout(clientmonitor);
-            }
-            stack_remove_slice(client->tag->stack, client->slice);
+// parses the entire description and stores the index of the root node in
+// root. The parser has to be freed with layout_parser_free() afterwards.
+static bool layout_parse(HSLayoutParser* p, const char* description,
+                         GString* errormsg, size_t* root) {
+    memset(p, 0, sizeof(*p));
+    p->input = description;
+    p->nodes = g_array_new(false, false, sizeof(HSLayoutNode));
+    p->windows = g_array_new(false, false, sizeof(Window));
+    p->errormsg = errormsg;
+    if (!layout_parse_frame(p, root)) {
+        return false;
+    }
+    layout_parse_whitespaces(p);
+    if (description[p->pos] != '\0') {
+        return layout_parse_error(p, p->pos,
+                                  "Layout description was too long");
+    }
+    return true;
+}
 
-            // insert it to buf
-            HSClient** buf = frame->content.clients.buf;
-            size_t count = frame->content.clients.count;
-            count++;
-            index = CLAMP(index, 0, count - 1);
-            buf = g_renew(HSClient*, buf, count);
-            memmove(buf + index + 1, buf + index,
-                    sizeof(buf[0]) * (count - index - 1));
-            buf[index] = client;
-            frame->content.clients.buf = buf;
-            frame->content.clients.count = count;
+static void layout_parser_free(HSLayoutParser* p) {
+    g_array_free(p->nodes, true);
+    g_array_free(p->windows, true);
+}
 
-            client->tag = tag;
-            stack_insert_slice(client->tag->stack, client->slice);
-            ewmh_window_update_tag(client->window, client->tag);
+bool check_frame_tree(const char* description, GString* errormsg) {
+    HSLayoutParser parser;
+    size_t root;
+    bool ok = layout_parse(&parser, description, errormsg, &root);
+    layout_parser_free(&parser);
+    return ok;
+}
 
-            index++;
-        }
-        // apply layout and selection
-        selection = (selection < frame->content.clients.count) ? selection : 0;
-        selection = (selection >= 0) ? selection : 0;
-        frame->content.clients.layout = layout;
-        frame->content.clients.selection = selection;
+bool load_frame_tree(HSFrame* frame, const char* description,
+                     GString* errormsg) {
+    HSLayoutParser parser;
+    size_t root;
+    // parse the entire description before anything is changed
+    bool ok = layout_parse(&parser, description, errormsg, &root);
+    if (ok) {
+        load_frame_node(frame, &parser, root);
     }
-    // jump over closing bracket
-    if (*description == LAYOUT_DUMP_BRACKETS[1]) {
-        description++;
-    } else {
-        g_string_append_printf(errormsg, "warning: missing closing bracket %c\n", LAYOUT_DUMP_BRACKETS[1]);
-    }
-    // and over whitespaces
-    description += strspn(description, LAYOUT_DUMP_WHITESPACES);
-    return description;
+    layout_parser_free(&parser);
+    return ok;
 }
 
 int find_layout_by_name(char* name) {
@@ -654,6 +966,7 @@ int frame_current_cycle_client_layout(int argc, char** argv, GString* output) {
         layout_index %= LAYOUT_COUNT;
     }
     g_cur_frame->content.clients.layout = layout_index;
+    frame_set_dirty(g_cur_frame);
     monitor_apply_layout(get_current_monitor());
     return 0;
 }
@@ -671,14 +984,14 @@ int frame_current_set_client_layout(int argc, char** argv, GString* output) {
     }
     if (g_cur_frame && g_cur_frame->type == TYPE_CLIENTS) {
         g_cur_frame->content.clients.layout = layout;
+        frame_set_dirty(g_cur_frame);
         monitor_apply_layout(get_current_monitor());
     }
     return 0;
 }
 
-void frame_apply_client_layout_linear(HSFrame* frame, Rectangle rect, bool vertical) {
-    HSClient** buf = frame->content.clients.buf;
-    size_t count = frame->content.clients.count;
+static void frame_plan_client_layout_linear(size_t count, Rectangle rect,
+                                           bool vertical, Rectangle* rects) {
     Rectangle cur = rect;
     int last_step_y;
     int last_step_x;
@@ -700,35 +1013,19 @@ void frame_apply_client_layout_linear(HSFrame* frame, Rectangle rect, bool verti
         step_x = cur.width;
     }
     for (int i = 0; i < count; i++) {
-        HSClient* client = buf[i];
         // add the space, if count does not divide frameheight without remainder
         cur.height += (i == count-1) ? last_step_y : 0;
         cur.width += (i == count-1) ? last_step_x : 0;
-        client_resize_tiling(client, cur, frame);
+        rects[i] = cur;
         cur.y += step_y;
         cur.x += step_x;
     }
 }
 
-void frame_apply_client_layout_horizontal(HSFrame* frame, Rectangle rect) {
-    frame_apply_client_layout_linear(frame, rect, false);
-}
-
-void frame_apply_client_layout_vertical(HSFrame* frame, Rectangle rect) {
-    frame_apply_client_layout_linear(frame, rect, true);
-}
-
-void frame_apply_client_layout_max(HSFrame* frame, Rectangle rect) {
-    HSClient** buf = frame->content.clients.buf;
-    size_t count = frame->content.clients.count;
-    int selection = frame->content.clients.selection;
+static void frame_plan_client_layout_max(size_t count, Rectangle rect,
+                                        Rectangle* rects) {
     for (int i = 0; i < count; i++) {
-        HSClient* client = buf[i];
-        client_setup_border(client, (g_cur_frame == frame) && (i == selection));
-        client_resize_tiling(client, rect, frame);
-        if (i == selection) {
-            client_raise(client);
-        }
+        rects[i] = rect;
     }
 }
 
@@ -745,10 +1042,8 @@ void frame_layout_grid_get_size(size_t count, int* res_rows, int* res_cols) {
     }
 }
 
-void frame_apply_client_layout_grid(HSFrame* frame, Rectangle rect) {
-    HSClient** buf = frame->content.clients.buf;
-    size_t count = frame->content.clients.count;
-    int selection = frame->content.clients.selection;
+static void frame_plan_client_layout_grid(size_t count, Rectangle rect,
+                                         Rectangle* rects) {
     if (count == 0) {
         return;
     }
@@ -777,97 +1072,212 @@ void frame_apply_client_layout_grid(HSFrame* frame, Rectangle rect) {
                 // fill small pixel gap in last col
                 cur.width += rect.width % cols;
             }
-
-            // apply size
-            HSClient* client = buf[i];
-            client_setup_border(client, (g_cur_frame == frame) && (i == selection));
-            client_resize_tiling(client, cur, frame);
+            rects[i] = cur;
             cur.x += width;
             i++;
         }
         cur.y += height;
     }
+}
 
+void frame_plan_client_layout(HSFrame* frame, Rectangle rect, Rectangle* rects) {
+    size_t count = frame->content.clients.count;
+    if (count == 0) {
+        return;
+    }
+    switch (frame->content.clients.layout) {
+        case LAYOUT_MAX:
+            frame_plan_client_layout_max(count, rect, rects);
+            break;
+        case LAYOUT_GRID:
+            frame_plan_client_layout_grid(count, rect, rects);
+            break;
+        default:
+            frame_plan_client_layout_linear(count, rect,
+                (frame->content.clients.layout == LAYOUT_VERTICAL), rects);
+            break;
+    }
 }
 
-void frame_apply_layout(HSFrame* frame, Rectangle rect) {
-    frame->last_rect = rect;
-    if (frame->type == TYPE_CLIENTS) {
-        size_t count = frame->content.clients.count;
-        if (!*g_smart_frame_surroundings || frame->parent) {
-            // apply frame gap
-            rect.height -= *g_frame_gap;
-            rect.width -= *g_frame_gap;
-            // apply frame border
-            rect.x += *g_frame_border_width;
-            rect.y += *g_frame_border_width;
-            rect.height -= *g_frame_border_width * 2;
-            rect.width -= *g_frame_border_width * 2;
-        }
-
-        rect.width = MAX(WINDOW_MIN_WIDTH, rect.width);
-        rect.height = MAX(WINDOW_MIN_HEIGHT, rect.height);
-
-        unsigned long border_color = g_frame_border_normal_color;
-        unsigned long bg_color = g_frame_bg_normal_color;
-        int bw = *g_frame_border_width;
-        if (g_cur_frame == frame) {
-            border_color = g_frame_border_active_color;
-            bg_color = g_frame_bg_active_color;
-        }
-        if (*g_smart_frame_surroundings && !frame->parent) {
-            bw = 0;
-        }
-        XSetWindowBorderWidth(g_display, frame->window, bw);
+void frame_plan_layout(HSFrame* frame, Rectangle rect, HSFramePlan* plan) {
+    if (!*g_smart_frame_surroundings || frame->parent) {
+        // apply frame gap
+        rect.height -= *g_frame_gap;
+        rect.width -= *g_frame_gap;
+        // apply frame border
+        rect.x += *g_frame_border_width;
+        rect.y += *g_frame_border_width;
+        rect.height -= *g_frame_border_width * 2;
+        rect.width -= *g_frame_border_width * 2;
+    }
+
+    rect.width = MAX(WINDOW_MIN_WIDTH, rect.width);
+    rect.height = MAX(WINDOW_MIN_HEIGHT, rect.height);
+
+    plan->border_color = g_frame_border_normal_color;
+    plan->bg_color = g_frame_bg_normal_color;
+    plan->opacity = g_frame_normal_opacity;
+    int bw = *g_frame_border_width;
+    if (g_cur_frame == frame) {
+        plan->border_color = g_frame_border_active_color;
+        plan->bg_color = g_frame_bg_active_color;
+        plan->opacity = g_frame_active_opacity;
+    }
+    if (*g_smart_frame_surroundings && !frame->parent) {
+        bw = 0;
+    }
+    plan->border_width = bw;
+    plan->window_rect = Rectangle(rect.x - bw, rect.y - bw,
+                                  rect.width, rect.height);
+
+    if (!smart_window_surroundings_active(frame)) {
+        // apply window gap
+        rect.x += *g_window_gap;
+        rect.y += *g_window_gap;
+        rect.width -= *g_window_gap;
+        rect.height -= *g_window_gap;
+
+        // apply frame padding
+        rect.x += *g_frame_padding;
+        rect.y += *g_frame_padding;
+        rect.width  -= *g_frame_padding * 2;
+        rect.height -= *g_frame_padding * 2;
+    }
+    plan->client_rect = rect;
+}
+
+// sends the planned frame window state to the X server. Only the requests
+// that change something are sent.
+static void frame_apply_plan(HSFrame* frame, HSFramePlan* plan) {
+    HSFramePlan* old = &frame->applied;
+    Rectangle rect = plan->window_rect;
+    // if the frame settings changed, everything has to be re-sent
+    bool valid = frame->applied_style == g_frame_style_generation;
+    bool size_changed = old->window_rect.width != rect.width
+                     || old->window_rect.height != rect.height;
+    bool border_changed = old->border_width != plan->border_width;
+    if (border_changed) {
+        XSetWindowBorderWidth(g_display, frame->window, plan->border_width);
+    }
+    if (!RECTANGLE_EQUALS(old->window_rect, rect)) {
         XMoveResizeWindow(g_display, frame->window,
-                          rect.x - bw,
-                          rect.y - bw,
-                          rect.width, rect.height);
-
-        frame_update_border(frame->window, border_color);
-
-        XSetWindowBackground(g_display, frame->window, bg_color);
-        if (*g_frame_bg_transparent) { // != ) {
+                          rect.x, rect.y, rect.width, rect.height);
+    }
+    // the double border depends on the window size
+    if (!valid || border_changed || size_changed
+        || old->border_color != plan->border_color) {
+        frame_update_border(frame->window, plan->border_color);
+    }
+    bool bg_changed = !valid || old->bg_color != plan->bg_color;
+    if (bg_changed) {
+        XSetWindowBackground(g_display, frame->window, plan->bg_color);
+    }
+    if (*g_frame_bg_transparent) {
+        if (!valid || size_changed || !frame->window_transparent) {
             window_cut_rect_hole(frame->window, rect.width, rect.height,
                                  *g_frame_transparent_width);
-        } else if (frame->window_transparent) {
-            window_make_intransparent(frame->window, rect.width, rect.height);
-        }
-        frame->window_transparent = *g_frame_bg_transparent;
-        if (g_cur_frame == frame) {
-            ewmh_set_window_opacity(frame->window, g_frame_active_opacity/100.0);
-        } else {
-            ewmh_set_window_opacity(frame->window, g_frame_normal_opacity/100.0);
         }
+    } else if (frame->window_transparent) {
+        window_make_intransparent(frame->window, rect.width, rect.height);
+    }
+    frame->window_transparent = *g_frame_bg_transparent;
+    if (!valid || old->opacity != plan->opacity) {
+        ewmh_set_window_opacity(frame->window, plan->opacity/100.0);
+    }
+    if (bg_changed) {
+        // areas exposed by a resize are painted by the X server
         XClearWindow(g_display, frame->window);
-        // move windows
-        if (count == 0) {
-            return;
-        }
+    }
+    *old = *plan;
+    frame->applied_style = g_frame_style_generation;
+}
+
+void frame_set_dirty(HSFrame* frame) {
+    if (frame) {
+        frame->tag->layout_generation++;
+    }
+    // stop at the first dirty frame, its parents are dirty already
+    while (frame && !frame->dirty) {
+        frame->dirty = true;
+        frame = frame->parent;
+    }
+}
 
-        if (!smart_window_surroundings_active(frame)) {
-            // apply window gap
-            rect.x += *g_window_gap;
-            rect.y += *g_window_gap;
-            rect.width -= *g_window_gap;
-            rect.height -= *g_window_gap;
+static void frame_set_dirty_helper(HSFrame* frame) {
+    frame->dirty = true;
+}
+
+void frame_set_dirty_recursive(HSFrame* frame) {
+    if (!frame) {
+        return;
+    }
+    frame->tag->layout_generation++;
+    frame_do_recursive(frame, frame_set_dirty_helper, 0);
+    for (frame = frame->parent; frame; frame = frame->parent) {
+        frame->dirty = true;
+    }
+}
 
-            // apply frame padding
-            rect.x += *g_frame_padding;
-            rect.y += *g_frame_padding;
-            rect.width  -= *g_frame_padding * 2;
-            rect.height -= *g_frame_padding * 2;
+void frame_apply_layout(HSFrame* frame, Rectangle rect) {
+    GArray* plans = g_array_new(false, false, sizeof(HSFrameTreePlan));
+    frame_plan_tree(frame, rect, plans);
+    frame_apply_tree_plan(plans);
+    g_array_free(plans, true);
+}
+
+void frame_apply_tree_plan(GArray* plans) {
+    for (int i = 0; i < plans->len; i++) {
+        HSFrameTreePlan* node = &g_array_index(plans, HSFrameTreePlan, i);
+        HSFrame* frame = node->frame;
+        frame->dirty = false;
+        if (!RECTANGLE_EQUALS(frame->last_rect, node->rect)) {
+            frame_index_invalidate(frame->tag);
         }
+        frame->last_rect = node->rect;
+        if (frame->type != TYPE_CLIENTS) {
+            continue;
+        }
+        frame_apply_plan(frame, &node->plan);
+        // move windows
+        HSClient** buf = frame->content.clients.buf;
+        int selection = frame->content.clients.selection;
+        for (int j = 0; j < frame->content.clients.count; j++) {
+            decoration_apply_plan(buf[j], &node->clients[j]);
+            if (frame->content.clients.layout == LAYOUT_MAX
+                && j == selection) {
+                client_raise(buf[j]);
+            }
+        }
+        g_free(node->clients);
+    }
+    g_array_set_size(plans, 0);
+}
 
-        if (frame->content.clients.layout == LAYOUT_MAX) {
-            frame_apply_client_layout_max(frame, rect);
-        } else if (frame->content.clients.layout == LAYOUT_GRID) {
-            frame_apply_client_layout_grid(frame, rect);
-        } else {
-            frame_apply_client_layout_linear(frame, rect,
-                (frame->content.clients.layout == LAYOUT_VERTICAL));
+void frame_plan_tree(HSFrame* frame, Rectangle rect, GArray* plans) {
+    if (!frame->dirty && RECTANGLE_EQUALS(frame->last_rect, rect)) {
+        // nothing changed in this subtree
+        return;
+    }
+    HSFrameTreePlan node;
+    node.frame = frame;
+    node.rect = rect;
+    node.clients = NULL;
+    if (frame->type == TYPE_CLIENTS) {
+        frame_plan_layout(frame, rect, &node.plan);
+        size_t count = frame->content.clients.count;
+        if (count) {
+            Rectangle* rects = g_new(Rectangle, count);
+            frame_plan_client_layout(frame, node.plan.client_rect, rects);
+            node.clients = g_new(HSDecorationPlan, count);
+            HSClient** buf = frame->content.clients.buf;
+            for (int i = 0; i < count; i++) {
+                client_plan_tiling(buf[i], rects[i], frame, &node.clients[i]);
+            }
+            g_free(rects);
         }
+        g_array_append_val(plans, node);
     } else { /* frame->type == TYPE_FRAMES */
+        g_array_append_val(plans, node);
         HSLayout* layout = &frame->content.layout;
         Rectangle first = rect;
         Rectangle second = rect;
@@ -880,8 +1290,8 @@ void frame_apply_layout(HSFrame* frame, Rectangle rect) {
             second.x += first.width;
             second.width -= first.width;
         }
-        frame_apply_layout(layout->a, first);
-        frame_apply_layout(layout->b, second);
+        frame_plan_tree(layout->a, first, plans);
+        frame_plan_tree(layout->b, second, plans);
     }
 }
 
@@ -933,7 +1343,7 @@ int frame_current_bring(int argc, char** argv, GString* output) {
     }
     HSTag* tag = get_current_monitor()->tag;
     tag_move_client(client, tag);
-    HSFrame* frame = find_frame_with_client(tag->frame, client);
+    HSFrame* frame = client->frame;
     if (frame != g_cur_frame) {
         frame_remove_client(frame, client);
         frame_insert_client(g_cur_frame, client);
@@ -959,6 +1369,7 @@ int frame_current_set_selection(int argc, char** argv) {
         index = frame->content.clients.count - 1;
     }
     frame->content.clients.selection = index;
+    frame_set_dirty(frame);
     HSClient* client = frame->content.clients.buf[index];
     client_window_focus(client);
     return 0;
@@ -984,6 +1395,7 @@ int frame_current_cycle_selection(int argc, char** argv) {
     index += count;
     index %= count;
     frame->content.clients.selection = index;
+    frame_set_dirty(frame);
     monitor_apply_layout(get_current_monitor());
     return 0;
 }
@@ -1037,6 +1449,7 @@ int cycle_all_command(int argc, char** argv) {
         index += frame->content.clients.count;
         index %= frame->content.clients.count;
         frame->content.clients.selection = index;
+        frame_set_dirty(frame);
     }
     HSClient* c = frame_focused_client(g_cur_frame);
     if (c) {
@@ -1114,6 +1527,7 @@ void cycle_frame(int direction, int new_window_index, bool skip_invisible) {
         // go one step to the right (i.e. in desired direction
         if (frame->type == TYPE_FRAMES) {
             int oldselection = frame->content.layout.selection;
+            frame_set_dirty(frame);
             if (oldselection == direction) {
                 // if we already reached the end,
                 // i.e. if we cannot go in the desired direction
@@ -1138,7 +1552,10 @@ void cycle_frame(int direction, int new_window_index, bool skip_invisible) {
         // and then to the left (i.e. find first leaf)
         while (frame->type == TYPE_FRAMES) {
             // then go deeper, with the other direction
-            frame->content.layout.selection = other_direction;
+            if (frame->content.layout.selection != other_direction) {
+                frame->content.layout.selection = other_direction;
+                frame_set_dirty(frame);
+            }
             frame = frame->content.layout.a;
         }
         /*         .
@@ -1161,6 +1578,7 @@ void cycle_frame(int direction, int new_window_index, bool skip_invisible) {
                 size_t count = frame->content.clients.count;
                 frame->content.clients.selection += count;
                 frame->content.clients.selection %= count;
+                frame_set_dirty(frame);
             }
         }
 
@@ -1203,6 +1621,8 @@ bool frame_split(HSFrame* frame, int align, int fraction) {
     HSFrame* second = frame_create_empty(frame, NULL);
     first->content = frame->content;
     first->type = frame->type;
+    frame_fix_inline_clients(first, frame);
+    frame_update_client_pointers(first, 0);
     second->type = TYPE_CLIENTS;
     frame->type = TYPE_FRAMES;
     frame->content.layout.align = align;
@@ -1210,6 +1630,7 @@ bool frame_split(HSFrame* frame, int align, int fraction) {
     frame->content.layout.b = second;
     frame->content.layout.selection = 0;
     frame->content.layout.fraction = fraction;
+    frame_set_dirty(frame);
     return true;
 }
 
@@ -1299,14 +1720,14 @@ int frame_split_command(int argc, char** argv, GString* output) {
         size_t nc2 = count1 - nc1 + count2; // new count for the 2nd frame
         HSFrame* child1 = frame->content.layout.a;
         HSFrame* child2 = frame->content.layout.b;
-        HSClient*** buf1 = &child1->content.clients.buf;
-        HSClient*** buf2 = &child2->content.clients.buf;
-        *buf2 = g_renew(HSClient*, *buf2, nc2);
-        memcpy(*buf2 + count2, *buf1 + nc1, (nc2 - count2) * sizeof(**buf2));
-        *buf1 = g_renew(HSClient*, *buf1, nc1);
+        HSClient** buf1 = child1->content.clients.buf;
+        HSClient** buf2 = frame_resize_client_buf(child2, nc2);
+        memcpy(buf2 + count2, buf1 + nc1, (nc2 - count2) * sizeof(*buf2));
+        frame_resize_client_buf(child1, nc1);
         child1->content.clients.count = nc1;
         child2->content.clients.count = nc2;
         child2->content.clients.layout = child1->content.clients.layout;
+        frame_update_client_pointers(child2, 0);
         if (child1->content.clients.selection >= nc1 && nc1 > 0) {
             child2->content.clients.selection =
                 child1->content.clients.selection - nc1 + count2;
@@ -1324,6 +1745,7 @@ int frame_split_command(int argc, char** argv, GString* output) {
     frame->content.layout.selection = selection;
     // reset focus
     g_cur_frame = frame_current_selection();
+    frame_set_dirty(g_cur_frame);
     // redraw monitor
     monitor_apply_layout(get_current_monitor());
     return 0;
@@ -1375,12 +1797,191 @@ int frame_change_fraction_command(int argc, char** argv, GString* output) {
     fraction += delta;
     fraction = CLAMP(fraction, (int)(FRAME_MIN_FRACTION * FRACTION_UNIT), (int)((1.0 - FRAME_MIN_FRACTION) * FRACTION_UNIT));
     parent->content.layout.fraction = fraction;
+    frame_set_dirty(parent);
     // arrange monitor
     monitor_apply_layout(get_current_monitor());
     return 0;
 }
 
+/* spatial index over the client frames of a tag
+ * For each direction, it holds the client frames sorted by the edge where
+ * they are entered when moving in that direction (e.g. by their left edge
+ * for DirRight) and then by their position along that edge. It is built
+ * from last_rect and rebuilt lazily after the geometry of a frame changed.
+ */
+typedef struct HSFrameIndex {
+    bool        valid;
+    bool        usable; // false if the rectangles are degenerated
+    GArray*     frames[4]; // of HSFrame*, indexed by enum HSDirection
+} HSFrameIndex;
+
+// the edge of the frame where it is entered when moving in direction dir
+static int frame_entry_edge(HSFrame* frame, int dir) {
+    Rectangle r = frame->last_rect;
+    switch (dir) {
+        case DirRight:  return r.x;
+        case DirLeft:   return r.x + r.width;
+        case DirDown:   return r.y;
+        default:        return r.y + r.height; // DirUp
+    }
+}
+
+// the edge of the frame where it is left when moving in direction dir
+static int frame_exit_edge(HSFrame* frame, int dir) {
+    Rectangle r = frame->last_rect;
+    switch (dir) {
+        case DirRight:  return r.x + r.width;
+        case DirLeft:   return r.x;
+        case DirDown:   return r.y + r.height;
+        default:        return r.y; // DirUp
+    }
+}
+
+// the interval [start, end) the frame covers along its edges in direction dir
+static void frame_edge_span(HSFrame* frame, int dir, int* start, int* end) {
+    Rectangle r = frame->last_rect;
+    if (dir == DirRight || dir == DirLeft) {
+        *start = r.y;
+        *end = r.y + r.height;
+    } else {
+        *start = r.x;
+        *end = r.x + r.width;
+    }
+}
+
+static gint frame_index_compare(gconstpointer a, gconstpointer b,
+                                gpointer data) {
+    int dir = GPOINTER_TO_INT(data);
+    HSFrame* fa = *(HSFrame**)a;
+    HSFrame* fb = *(HSFrame**)b;
+    int ea = frame_entry_edge(fa, dir);
+    int eb = frame_entry_edge(fb, dir);
+    if (ea != eb) {
+        return (ea < eb) ? -1 : 1;
+    }
+    int sa, sb, end;
+    frame_edge_span(fa, dir, &sa, &end);
+    frame_edge_span(fb, dir, &sb, &end);
+    return (sa < sb) ? -1 : (sa > sb);
+}
+
+static void frame_index_add(HSFrame* frame, void* data) {
+    HSFrameIndex* index = (HSFrameIndex*)data;
+    if (frame->type != TYPE_CLIENTS) {
+        return;
+    }
+    if (frame->last_rect.width <= 0 || frame->last_rect.height <= 0) {
+        // degenerated frames break the ordering along the edges
+        index->usable = false;
+    }
+    for (int dir = 0; dir < LENGTH(index->frames); dir++) {
+        g_array_append_val(index->frames[dir], frame);
+    }
+}
+
+static HSFrameIndex* frame_index_get(HSTag* tag) {
+    HSFrameIndex* index = tag->frame_index;
+    if (!index) {
+        index = g_new0(HSFrameIndex, 1);
+        for (int dir = 0; dir < LENGTH(index->frames); dir++) {
+            index->frames[dir] = g_array_new(false, false, sizeof(HSFrame*));
+        }
+        tag->frame_index = index;
+    }
+    if (!index->valid) {
+        index->usable = true;
+        for (int dir = 0; dir < LENGTH(index->frames); dir++) {
+            g_array_set_size(index->frames[dir], 0);
+        }
+        frame_do_recursive_data(tag->frame, frame_index_add, 0, index);
+        for (int dir = 0; dir < LENGTH(index->frames); dir++) {
+            g_array_sort_with_data(index->frames[dir], frame_index_compare,
+                                   GINT_TO_POINTER(dir));
+        }
+        index->valid = true;
+    }
+    return index;
+}
+
+static void frame_index_invalidate(HSTag* tag) {
+    if (tag && tag->frame_index) {
+        tag->frame_index->valid = false;
+    }
+}
+
+void frame_index_destroy(HSFrameIndex* index) {
+    if (!index) {
+        return;
+    }
+    for (int dir = 0; dir < LENGTH(index->frames); dir++) {
+        g_array_free(index->frames[dir], true);
+    }
+    g_free(index);
+}
+
+// finds the client frame that touches frame in direction dir and has the
+// smallest position along the common edge. returns NULL if there is none
+static HSFrame* frame_index_lookup(HSFrameIndex* index, HSFrame* frame,
+                                   int dir) {
+    GArray* frames = index->frames[dir];
+    int edge = frame_exit_edge(frame, dir);
+    int start, end;
+    frame_edge_span(frame, dir, &start, &end);
+    // binary search for the first frame on this edge that ends behind start
+    size_t lo = 0, hi = frames->len;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        HSFrame* f = g_array_index(frames, HSFrame*, mid);
+        int e = frame_entry_edge(f, dir);
+        int fs, fe;
+        frame_edge_span(f, dir, &fs, &fe);
+        if (e < edge || (e == edge && fe <= start)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo >= frames->len) {
+        return NULL;
+    }
+    HSFrame* f = g_array_index(frames, HSFrame*, lo);
+    int fs, fe;
+    frame_edge_span(f, dir, &fs, &fe);
+    if (frame_entry_edge(f, dir) != edge || fs >= end) {
+        return NULL;
+    }
+    return f;
+}
+
+// returns the child of the lowest common ancestor of frame and other that
+// contains other
+static HSFrame* frame_child_towards(HSFrame* frame, HSFrame* other) {
+    for (HSFrame* child = other; child->parent; child = child->parent) {
+        for (HSFrame* f = frame; f; f = f->parent) {
+            if (f == child->parent) {
+                return child;
+            }
+        }
+    }
+    return NULL;
+}
+
 HSFrame* frame_neighbour(HSFrame* frame, char direction) {
+    HSTag* tag = frame->tag;
+    // the index only can be used if all last_rects are up to date
+    if (frame->type == TYPE_CLIENTS && !tag->frame->dirty) {
+        int dir = char_to_direction(direction);
+        if (dir < 0) {
+            return NULL;
+        }
+        HSFrameIndex* index = frame_index_get(tag);
+        if (index->usable) {
+            // the neighbour is the subtree on the other side of the split
+            // between both frames
+            HSFrame* other = frame_index_lookup(index, frame, dir);
+            return other ? frame_child_towards(frame, other) : NULL;
+        }
+    }
     HSFrame* other;
     bool found = false;
     while (frame->parent) {
@@ -1511,6 +2112,7 @@ int frame_focus_command(int argc, char** argv, GString* output) {
     } else if (!external_only &&
         (index = frame_inner_neighbour_index(g_cur_frame, direction)) != -1) {
         g_cur_frame->content.clients.selection = index;
+        frame_set_dirty(g_cur_frame);
         frame_focus_recursive(g_cur_frame);
         monitor_apply_layout(get_current_monitor());
     } else {
@@ -1521,6 +2123,7 @@ int frame_focus_command(int argc, char** argv, GString* output) {
             int selection = parent->content.layout.selection;
             selection = (selection == 1) ? 0 : 1;
             parent->content.layout.selection = selection;
+            frame_set_dirty(parent);
             // change focus if possible
             frame_focus_recursive(parent);
             monitor_apply_layout(get_current_monitor());
@@ -1584,8 +2187,10 @@ int frame_move_window_command(int argc, char** argv, GString* output) {
         HSClient* tmp = buf[selection];
         buf[selection] = buf[index];
         buf[index] = tmp;
+        frame_update_client_pointers(g_cur_frame, MIN(selection, index));
 
         g_cur_frame->content.clients.selection = index;
+        frame_set_dirty(g_cur_frame);
         frame_focus_recursive(g_cur_frame);
         monitor_apply_layout(get_current_monitor());
     } else {
@@ -1600,6 +2205,7 @@ int frame_move_window_command(int argc, char** argv, GString* output) {
             HSFrame* parent = neighbour->parent;
             assert(parent);
             parent->content.layout.selection = ! parent->content.layout.selection;
+            frame_set_dirty(parent);
             frame_focus_recursive(parent);
             // focus right window in frame
             HSFrame* frame = g_cur_frame;
@@ -1610,6 +2216,7 @@ int frame_move_window_command(int argc, char** argv, GString* output) {
             for (i = 0; i < count; i++) {
                 if (buf[i] == client) {
                     frame->content.clients.selection = i;
+                    frame_set_dirty(frame);
                     client_window_focus(buf[i]);
                     break;
                 }
@@ -1652,39 +2259,25 @@ HSClient* frame_focused_client(HSFrame* frame) {
 // hidden.
 // returns true if win was found and focused, else returns false
 bool frame_focus_client(HSFrame* frame, HSClient* client) {
-    if (!frame) {
+    if (!frame || !find_frame_with_client(frame, client)) {
         return false;
     }
-    if (frame->type == TYPE_CLIENTS) {
-        int i;
-        size_t count = frame->content.clients.count;
-        HSClient** buf = frame->content.clients.buf;
-        // search for win in buf
-        for (i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                // if found, set focus to it
-                frame->content.clients.selection = i;
-                return true;
-            }
-        }
-        return false;
-    } else {
-        // type == TYPE_FRAMES
-        // search in subframes
-        bool found = frame_focus_client(frame->content.layout.a, client);
-        if (found) {
-            // set selection to first frame
-            frame->content.layout.selection = 0;
-            return true;
-        }
-        found = frame_focus_client(frame->content.layout.b, client);
-        if (found) {
-            // set selection to second frame
-            frame->content.layout.selection = 1;
-            return true;
+    // set focus to it
+    HSFrame* f = client->frame;
+    if (f->content.clients.selection != client->frame_index) {
+        f->content.clients.selection = client->frame_index;
+        frame_set_dirty(f);
+    }
+    // and select the path to it
+    for (; f != frame; f = f->parent) {
+        HSLayout* layout = &f->parent->content.layout;
+        int selection = (layout->a == f) ? 0 : 1;
+        if (layout->selection != selection) {
+            layout->selection = selection;
+            frame_set_dirty(f->parent);
         }
-        return false;
     }
+    return true;
 }
 
 // focus a window
@@ -1743,6 +2336,11 @@ int frame_focus_recursive(HSFrame* frame) {
                 frame->content.layout.a :
                 frame->content.layout.b;
     }
+    if (g_cur_frame != frame) {
+        // the frame colors of both frames change
+        frame_set_dirty(g_cur_frame);
+        frame_set_dirty(frame);
+    }
     g_cur_frame = frame;
     frame_unfocus();
     if (frame->content.clients.count) {
@@ -1846,6 +2444,7 @@ static void frame_rotate(HSFrame* frame) {
 
 int layout_rotate_command() {
     frame_do_recursive(get_current_monitor()->tag->frame, frame_rotate, -1);
+    frame_set_dirty_recursive(get_current_monitor()->tag->frame);
     monitor_apply_layout(get_current_monitor());
     return 0;
 }
@@ -1872,6 +2471,7 @@ int frame_remove_command(int argc, char** argv) {
     // and insert them to other child.. inefficiently
     int i;
     for (i = 0; i < count; i++) {
+        wins[i]->frame = NULL;
         frame_insert_client(second, wins[i]);
     }
     g_free(wins);
@@ -1885,12 +2485,18 @@ int frame_remove_command(int argc, char** argv) {
     slice_destroy(parent->slice);
     // copy all other elements
     *parent = *second;
+    if (parent->type == TYPE_CLIENTS) {
+        frame_fix_inline_clients(parent, second);
+    }
     // fix childs' parent-pointer
     if (parent->type == TYPE_FRAMES) {
         parent->content.layout.a->parent = parent;
         parent->content.layout.b->parent = parent;
+    } else {
+        frame_update_client_pointers(parent, 0);
     }
-    g_free(second);
+    frame_pool_free(parent->tag->frame_pool, second);
+    frame_set_dirty_recursive(parent);
     // re-layout
     frame_focus_recursive(parent);
     monitor_apply_layout(get_current_monitor());
@@ -14,6 +14,7 @@
 #include "monitor.h"
 #include "tag.h"
 #include "floating.h"
+#include "decoration.h"
 
 #define LAYOUT_DUMP_BRACKETS "()" /* must consist of exactly two chars */
 #define LAYOUT_DUMP_WHITESPACES " \t\n" /* must be at least one char */
@@ -72,6 +73,28 @@ typedef struct HSLayout {
                   // FRACTION_UNIT/2 means 50%
 } HSLayout;
 
+// the state of a frame window as computed by frame_plan_layout()
+typedef struct HSFramePlan {
+    Rectangle       window_rect;  // geometry of the frame window
+    int             border_width;
+    unsigned long   border_color;
+    unsigned long   bg_color;
+    int             opacity;      // in percent
+    Rectangle       client_rect;  // area the clients are arranged in
+} HSFramePlan;
+
+// the geometry of a frame that is re-layouted, and for client frames the
+// state of its frame window and its clients
+typedef struct HSFrameTreePlan {
+    struct HSFrame* frame;
+    Rectangle       rect;    // the rectangle the frame is drawn into
+    HSFramePlan     plan;    // only for client frames
+    HSDecorationPlan* clients; // one per client, NULL if there are none
+} HSFrameTreePlan;
+
+// number of clients a client frame can hold without allocating memory
+#define FRAME_INLINE_CLIENTS 4
+
 typedef struct HSFrame {
     union {
         HSLayout layout;
@@ -90,6 +113,11 @@ typedef struct HSFrame {
     int    window_transparent;
     bool   window_visible;
     Rectangle  last_rect; // last rectangle when being drawn
+    bool   dirty; // if the frame (or a subframe) needs to be re-layouted
+    HSFramePlan applied; // frame window state last sent to the X server
+    // storage for content.clients.buf if there are only few clients
+    struct HSClient* inline_clients[FRAME_INLINE_CLIENTS];
+    int    applied_style; // style generation the frame window state belongs to
 } HSFrame;
 
 
@@ -102,6 +130,10 @@ extern int* g_window_gap;
 void layout_init();
 void layout_destroy();
 // for frames
+// the memory for the frames of a tag
+struct HSFramePool* frame_pool_create();
+// frees the memory of all frames in the pool at once
+void frame_pool_destroy(struct HSFramePool* pool);
 HSFrame* frame_create_empty(HSFrame* parent, HSTag* parenttag);
 void frame_insert_client(HSFrame* frame, struct HSClient* client);
 HSFrame* lookup_frame(HSFrame* root, const char* path);
@@ -115,12 +147,21 @@ bool frame_remove_client(HSFrame* frame, struct HSClient* client);
 // destroys a frame and all its childs
 // then all Windows in it are collected and returned
 // YOU have to g_free the resulting window-buf
+// The clients are not touched (they may be freed already on shutdown), so
+// callers reusing them have to reset their frame pointer
 void frame_destroy(HSFrame* frame, struct HSClient*** buf, size_t* count);
 bool frame_split(HSFrame* frame, int align, int fraction);
 int frame_split_command(int argc, char** argv, GString* output);
 int frame_change_fraction_command(int argc, char** argv, GString* output);
 
+// applies the layout to the frame tree. Subtrees that are not dirty and
+// whose rectangle did not change are skipped.
 void frame_apply_layout(HSFrame* frame, Rectangle rect);
+// marks the frame and all its parents dirty, i.e. the frame is re-layouted
+// on the next frame_apply_layout()
+void frame_set_dirty(HSFrame* frame);
+// marks the frame, all its subframes and its parents dirty
+void frame_set_dirty_recursive(HSFrame* frame);
 void frame_apply_floating_layout(HSFrame* frame, struct HSMonitor* m);
 void frame_update_frame_window_visibility(HSFrame* frame);
 void reset_frame_colors();
@@ -128,10 +169,13 @@ HSFrame* get_toplevel_frame(HSFrame* frame);
 
 void print_frame_tree(HSFrame* frame, GString* output);
 void dump_frame_tree(HSFrame* frame, GString* output);
-// create apply a described layout to a frame and its subframes
-// returns pointer to string that was not parsed yet
-// or NULL on an error
-char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg);
+// apply a described layout to a frame and its subframes
+// the description is validated completely before the frame is changed.
+// returns false and leaves the frame untouched on an error
+bool load_frame_tree(HSFrame* frame, const char* description,
+                     GString* errormsg);
+// only validate a layout description, without touching any frame
+bool check_frame_tree(const char* description, GString* errormsg);
 int find_layout_by_name(char* name);
 int find_align_by_name(char* name);
 
@@ -147,6 +191,7 @@ void frame_unfocus(); // unfocus currently focused window
 // get neighbour in a specific direction 'l' 'r' 'u' 'd' (left, right,...)
 // returns the neighbour or NULL if there is no one
 HSFrame* frame_neighbour(HSFrame* frame, char direction);
+void frame_index_destroy(struct HSFrameIndex* index);
 int frame_inner_neighbour_index(HSFrame* frame, char direction);
 int frame_focus_command(int argc, char** argv, GString* output);
 
@@ -162,9 +207,19 @@ int layout_rotate_command();
 // returns success or failure
 int frame_foreach_client(HSFrame* frame, ClientAction action, void* data);
 
-void frame_apply_client_layout_linear(HSFrame* frame, Rectangle rect, bool vertical);
-void frame_apply_client_layout_horizontal(HSFrame* frame, Rectangle rect);
-void frame_apply_client_layout_vertical(HSFrame* frame, Rectangle rect);
+// compute the frame window state of a client frame drawn into rect
+// this does not touch the X server
+void frame_plan_layout(HSFrame* frame, Rectangle rect, HSFramePlan* plan);
+// compute the rectangle of each client of a client frame, such that they
+// are arranged within rect. rects must have space for all clients
+void frame_plan_client_layout(HSFrame* frame, Rectangle rect, Rectangle* rects);
+// compute the geometry of all frames in the subtree of frame that need to be
+// layouted and append a HSFrameTreePlan for each of them to plans.
+// this neither touches the X server nor changes any frame or client
+void frame_plan_tree(HSFrame* frame, Rectangle rect, GArray* plans);
+// send the plans computed by frame_plan_tree() to the X server, update the
+// frames accordingly and free the plans
+void frame_apply_tree_plan(GArray* plans);
 int frame_current_cycle_client_layout(int argc, char** argv, GString* output);
 int frame_current_set_client_layout(int argc, char** argv, GString* output);
 int frame_split_count_to_root(HSFrame* frame, int align);
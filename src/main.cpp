@@ -277,8 +277,31 @@ int print_layout_command(int argc, char** argv, GString* output) {
     }
     assert(tag != NULL);
 
-    HSFrame* frame = lookup_frame(tag->frame, argc >= 3 ? argv[2] : "");
-    if (argc > 0 && !strcmp(argv[0], "dump")) {
+    bool dump = argc > 0 && !strcmp(argv[0], "dump");
+    if (argc < 3 || argv[2][0] == '\0') {
+        // the output for the entire tree is remembered until it changes
+        GString** cache = &tag->layout_cache[dump ? 1 : 0];
+        int* generation = &tag->layout_cache_generation[dump ? 1 : 0];
+        if (!*cache || *generation != tag->layout_generation
+            || (!dump && tag->layout_cache_style != g_tree_style_generation)) {
+            if (*cache) {
+                g_string_truncate(*cache, 0);
+            } else {
+                *cache = g_string_new("");
+            }
+            if (dump) {
+                dump_frame_tree(tag->frame, *cache);
+            } else {
+                print_frame_tree(tag->frame, *cache);
+                tag->layout_cache_style = g_tree_style_generation;
+            }
+            *generation = tag->layout_generation;
+        }
+        g_string_append_len(output, (*cache)->str, (*cache)->len);
+        return 0;
+    }
+    HSFrame* frame = lookup_frame(tag->frame, argv[2]);
+    if (dump) {
         dump_frame_tree(frame, output);
     } else {
         print_frame_tree(frame, output);
@@ -306,9 +329,11 @@ int load_command(int argc, char** argv, GString* output) {
         tag = m->tag;
     }
     assert(tag != NULL);
-    char* rest = load_frame_tree(tag->frame, layout_string, output);
-    if (output->len > 0) {
+    if (!load_frame_tree(tag->frame, layout_string, output)) {
         g_string_prepend(output, "load: ");
+        g_string_append_printf(output,
+            "%s: Error while parsing!\n", argv[0]);
+        return HERBST_INVALID_ARGUMENT;
     }
     tag_set_flags_dirty(); // we probably changed some window positions
     // arrange monitor
@@ -322,18 +347,6 @@ int load_command(int argc, char** argv, GString* output) {
     } else {
         frame_hide_recursive(tag->frame);
     }
-    if (!rest) {
-        g_string_append_printf(output,
-            "%s: Error while parsing!\n", argv[0]);
-        return HERBST_INVALID_ARGUMENT;
-    }
-    if (rest[0] != '\0') { // if string was not parsed completely
-        g_string_append_printf(output,
-            "%s: Layout description was too long\n", argv[0]);
-        g_string_append_printf(output,
-            "%s: \"%s\" has not been parsed\n", argv[0], rest);
-        return HERBST_INVALID_ARGUMENT;
-    }
     return 0;
 }
 
@@ -444,6 +457,8 @@ int raise_command(int argc, char** argv, GString* output) {
         client_raise(client);
     } else {
         XRaiseWindow(g_display, win);
+        // this may have moved a window of any stack
+        stack_forget_applied_orders();
     }
     return 0;
 }
@@ -541,13 +556,19 @@ void event_on_configure(XEvent event) {
             if (width_requested) newRect.width = cre->width;
             if (height_requested) newRect.height = cre->height;
         }
+        // the client waits for a ConfigureNotify even if its request is
+        // denied or does not change the geometry (ICCCM 4.1.5), so it must
+        // not be skipped as redundant
+        client->dec.applied_inner_rect = Rectangle(0, 0, -1, -1);
         if (changes && is_client_floated(client)) {
             client->float_size = newRect;
             client_resize_floating(client, find_monitor_with_tag(client->tag));
         } else if (changes && client->pseudotile) {
             client->float_size = newRect;
+            client_set_layout_dirty(client);
             monitor_apply_layout(find_monitor_with_tag(client->tag));
-        } else {
+        }
+        if (client->dec.applied_inner_rect.width < 0) {
         // FIXME: why send event and not XConfigureWindow or XMoveResizeWindow??
             client_send_configure(client);
         }
@@ -872,7 +893,7 @@ void enternotify(XEvent* event) {
         HSClient* c = get_client_from_window(ce->window);
         HSFrame* target;
         if (c && c->tag->floating == false
-              && (target = find_frame_with_client(c->tag->frame, c))
+              && (target = c->frame)
               && target->content.clients.layout == LAYOUT_MAX
               && frame_focused_client(target) != c) {
             // don't allow focus_follows_mouse if another window would be
@@ -884,9 +905,8 @@ void enternotify(XEvent* event) {
 }
 
 void expose(XEvent* event) {
-    //if (event->xexpose.count > 0) return;
-    //Window ewin = event->xexpose.window;
-    //HSDebug("name is: Expose for window %lx\n", ewin);
+    //HSDebug("name is: Expose for window %lx\n", event->xexpose.window);
+    decoration_expose(&event->xexpose);
 }
 
 void focusin(XEvent* event) {
@@ -903,7 +923,8 @@ void mappingnotify(XEvent* event) {
         // regrab when keyboard map changes
         XMappingEvent *ev = &event->xmapping;
         XRefreshKeyboardMapping(ev);
-        if(ev->request == MappingKeyboard) {
+        // the numlock modifier may change with either of them
+        if(ev->request == MappingKeyboard || ev->request == MappingModifier) {
             regrab_keys();
             //TODO: mouse_regrab_all();
         }
@@ -963,6 +984,7 @@ void propertynotify(XEvent* event) {
                 client_update_wm_hints(client);
             } else if (ev->atom == XA_WM_NORMAL_HINTS) {
                 updatesizehints(client);
+                client_set_layout_dirty(client);
                 HSMonitor* m = find_monitor_with_tag(client->tag);
                 if (m) monitor_apply_layout(m);
             } else if (ev->atom == XA_WM_NAME ||
@@ -1025,14 +1047,30 @@ int main(int argc, char* argv[]) {
     int x11_fd;
     fd_set in_fds;
     x11_fd = ConnectionNumber(g_display);
+    // write the properties that changed while starting up
+    ewmh_flush();
+    XFlush(g_display);
     while (!g_aboutToQuit) {
         FD_ZERO(&in_fds);
         FD_SET(x11_fd, &in_fds);
-        // wait for an event or a signal
-        select(x11_fd + 1, &in_fds, 0, 0, NULL);
+        // wait for an event or a signal, or until the next frame of a drag
+        // or until unused decoration pixmaps have to be freed
+        struct timeval timeout;
+        bool use_timeout = mouse_drag_timeout(&timeout);
+        long long pool_wait = decorations_evict_idle_pixmaps();
+        if (pool_wait >= 0 && (!use_timeout
+            || pool_wait < timeout.tv_sec * 1000 + timeout.tv_usec / 1000)) {
+            timeout.tv_sec = pool_wait / 1000;
+            timeout.tv_usec = (pool_wait % 1000) * 1000;
+            use_timeout = true;
+        }
+        // send the requests of the eviction
+        XFlush(g_display);
+        select(x11_fd + 1, &in_fds, 0, 0, use_timeout ? &timeout : NULL);
         if (g_aboutToQuit) {
             break;
         }
+        mouse_drag_tick();
         XSync(g_display, False);
         while (XQLength(g_display)) {
             XNextEvent(g_display, &event);
@@ -1040,6 +1078,13 @@ int main(int argc, char* argv[]) {
             if (handler != NULL) {
                 handler(&event);
             }
+            if (!XQLength(g_display)) {
+                // write the root window properties changed by this batch
+                // before anybody is notified of its results. IPC replies
+                // are sent within the batch, so ipc_handle_connection()
+                // flushes on its own
+                ewmh_flush();
+            }
             XSync(g_display, False);
         }
     }
@@ -32,6 +32,8 @@ static int* g_monitors_locked;
 static int* g_swap_monitors_to_get_tag;
 static int* g_smart_frame_surroundings;
 static int* g_mouse_recenter_gap;
+static int* g_layout_threads;
+static GThreadPool* g_layout_pool; // plans monitors, created on first use
 static HSStack* g_monitor_stack;
 static GArray*     g_monitors; // Array of HSMonitor*
 static HSObject*   g_monitor_object;
@@ -52,6 +54,7 @@ void monitor_init() {
     g_swap_monitors_to_get_tag = &(settings_find("swap_monitors_to_get_tag")->value.i);
     g_smart_frame_surroundings = &(settings_find("smart_frame_surroundings")->value.i);
     g_mouse_recenter_gap       = &(settings_find("mouse_recenter_gap")->value.i);
+    g_layout_threads           = &(settings_find("layout_threads")->value.i);
     g_monitor_stack = stack_create();
     g_monitor_object = hsobject_create_and_link(hsobject_root(), "monitors");
     HSAttribute attributes[] = {
@@ -63,6 +66,9 @@ void monitor_init() {
 }
 
 void monitor_destroy() {
+    if (g_layout_pool) {
+        g_thread_pool_free(g_layout_pool, true, true);
+    }
     for (unsigned int i = 0; i < g_monitors->len; i++) {
         HSMonitor* m = monitor_with_index(i);
         stack_remove_slice(g_monitor_stack, m->slice);
@@ -80,41 +86,66 @@ void monitor_destroy() {
     g_array_free(g_monitors, true);
 }
 
+// restacks and focuses the monitor, which the plan depends on
+static void monitor_prepare_layout(HSMonitor* monitor) {
+    monitor_restack(monitor);
+    if (get_current_monitor() == monitor) {
+        frame_focus_recursive(monitor->tag->frame);
+    }
+}
+
+// computes the geometry of the frames of the monitor without touching the
+// X server. This only reads the monitor and its tag, so the monitors can be
+// planned in parallel.
+static void monitor_plan_layout(HSMonitor* monitor, GArray* plans) {
+    Rectangle rect = monitor->rect;
+    // apply pad
+    rect.x += monitor->pad_left;
+    rect.width -= (monitor->pad_left + monitor->pad_right);
+    rect.y += monitor->pad_up;
+    rect.height -= (monitor->pad_up + monitor->pad_down);
+    if (!*g_smart_frame_surroundings || monitor->tag->frame->type == TYPE_FRAMES ) {
+        // apply frame gap
+        rect.x += *g_frame_gap;
+        rect.y += *g_frame_gap;
+        rect.height -= *g_frame_gap;
+        rect.width -= *g_frame_gap;
+    }
+    if (!monitor->tag->floating) {
+        frame_plan_tree(monitor->tag->frame, rect, plans);
+    }
+}
+
+// moves the frames and clients of the monitor as planned before
+static void monitor_apply_plan(HSMonitor* monitor, GArray* plans) {
+    monitor->dirty = false;
+    if (monitor->tag->floating) {
+        frame_apply_floating_layout(monitor->tag->frame, monitor);
+        // the tiling layout has to be re-applied completely when
+        // the tag is tiled again
+        frame_set_dirty_recursive(monitor->tag->frame);
+    } else {
+        frame_apply_tree_plan(plans);
+        if (!monitor->lock_frames && !monitor->tag->floating) {
+            frame_update_frame_window_visibility(monitor->tag->frame);
+        }
+    }
+    // remove all enternotify-events from the event queue that were
+    // generated while arranging the clients on this monitor
+    drop_enternotify_events();
+}
+
 void monitor_apply_layout(HSMonitor* monitor) {
     if (monitor) {
         if (*g_monitors_locked) {
             monitor->dirty = true;
             return;
         }
-        monitor->dirty = false;
-        Rectangle rect = monitor->rect;
-        // apply pad
-        rect.x += monitor->pad_left;
-        rect.width -= (monitor->pad_left + monitor->pad_right);
-        rect.y += monitor->pad_up;
-        rect.height -= (monitor->pad_up + monitor->pad_down);
-        if (!*g_smart_frame_surroundings || monitor->tag->frame->type == TYPE_FRAMES ) {
-            // apply frame gap
-            rect.x += *g_frame_gap;
-            rect.y += *g_frame_gap;
-            rect.height -= *g_frame_gap;
-            rect.width -= *g_frame_gap;
-        }
-        monitor_restack(monitor);
-        if (get_current_monitor() == monitor) {
-            frame_focus_recursive(monitor->tag->frame);
-        }
-        if (monitor->tag->floating) {
-            frame_apply_floating_layout(monitor->tag->frame, monitor);
-        } else {
-            frame_apply_layout(monitor->tag->frame, rect);
-            if (!monitor->lock_frames && !monitor->tag->floating) {
-                frame_update_frame_window_visibility(monitor->tag->frame);
-            }
-        }
-        // remove all enternotify-events from the event queue that were
-        // generated while arranging the clients on this monitor
-        drop_enternotify_events();
+        GArray* plans = g_array_new(false, false, sizeof(HSFrameTreePlan));
+        monitor_prepare_layout(monitor);
+        monitor_plan_layout(monitor, plans);
+        monitor_apply_plan(monitor, plans);
+        g_array_free(plans, true);
     }
 }
 
@@ -787,8 +818,84 @@ int monitor_count() {
     return g_monitors->len;
 }
 
+static void monitor_set_layout_dirty(HSMonitor* monitor) {
+    frame_set_dirty_recursive(monitor->tag->frame);
+}
+
+typedef struct {
+    HSMonitor*  monitor;
+    GArray*     plans;
+} HSMonitorPlanJob;
+
+static GMutex   g_layout_mutex;
+static GCond    g_layout_cond;
+static int      g_layout_jobs_pending;
+
+static void monitor_plan_job(gpointer data, gpointer user_data) {
+    (void)user_data;
+    HSMonitorPlanJob* job = (HSMonitorPlanJob*)data;
+    monitor_plan_layout(job->monitor, job->plans);
+    g_mutex_lock(&g_layout_mutex);
+    g_layout_jobs_pending--;
+    g_cond_signal(&g_layout_cond);
+    g_mutex_unlock(&g_layout_mutex);
+}
+
+// plans each monitor in a worker thread and waits for all of them. Nothing
+// else runs meanwhile, so the workers only share state that is read.
+static void monitors_plan_layout_parallel(GArray** plans) {
+    if (!g_layout_pool) {
+        g_layout_pool = g_thread_pool_new(monitor_plan_job, NULL,
+                                          *g_layout_threads, false, NULL);
+    } else {
+        g_thread_pool_set_max_threads(g_layout_pool, *g_layout_threads, NULL);
+    }
+    HSMonitorPlanJob* jobs = g_new(HSMonitorPlanJob, g_monitors->len);
+    g_mutex_lock(&g_layout_mutex);
+    g_layout_jobs_pending = g_monitors->len;
+    g_mutex_unlock(&g_layout_mutex);
+    for (int i = 0; i < g_monitors->len; i++) {
+        jobs[i].monitor = monitor_with_index(i);
+        jobs[i].plans = plans[i];
+        g_thread_pool_push(g_layout_pool, jobs + i, NULL);
+    }
+    g_mutex_lock(&g_layout_mutex);
+    while (g_layout_jobs_pending > 0) {
+        g_cond_wait(&g_layout_cond, &g_layout_mutex);
+    }
+    g_mutex_unlock(&g_layout_mutex);
+    g_free(jobs);
+}
+
 void all_monitors_apply_layout() {
-    monitor_foreach(monitor_apply_layout);
+    // this is called if some global setting changed, so each frame
+    // has to be re-layouted
+    monitor_foreach(monitor_set_layout_dirty);
+    if (*g_monitors_locked) {
+        monitor_foreach(monitor_apply_layout);
+        return;
+    }
+    // the focus has to be final before the frame colors are planned
+    for (int i = 0; i < g_monitors->len; i++) {
+        monitor_prepare_layout(monitor_with_index(i));
+    }
+    // compute the geometry of all monitors before moving anything
+    GArray** plans = g_new(GArray*, g_monitors->len);
+    for (int i = 0; i < g_monitors->len; i++) {
+        plans[i] = g_array_new(false, false, sizeof(HSFrameTreePlan));
+    }
+    if (*g_layout_threads > 0 && g_monitors->len > 1) {
+        monitors_plan_layout_parallel(plans);
+    } else {
+        for (int i = 0; i < g_monitors->len; i++) {
+            monitor_plan_layout(monitor_with_index(i), plans[i]);
+        }
+    }
+    for (int i = 0; i < g_monitors->len; i++) {
+        monitor_apply_plan(monitor_with_index(i), plans[i]);
+        g_array_free(plans[i], true);
+    }
+    g_free(plans);
 }
 
 int monitor_set_tag(HSMonitor* monitor, HSTag* tag) {
@@ -820,6 +927,8 @@ int monitor_set_tag(HSMonitor* monitor, HSTag* tag) {
             // swap tags
             other->tag = monitor->tag;
             monitor->tag = tag;
+            frame_set_dirty_recursive(other->tag->frame);
+            frame_set_dirty_recursive(tag->frame);
             // reset focus
             frame_focus_recursive(tag->frame);
             /* TODO: find the best order of restacking and layouting */
@@ -845,6 +954,8 @@ int monitor_set_tag(HSMonitor* monitor, HSTag* tag) {
     monitor->tag_previous = old_tag;
     // 1. show new tag
     monitor->tag = tag;
+    // settings may have changed while the tag was invisible
+    frame_set_dirty_recursive(tag->frame);
     // first reset focus and arrange windows
     frame_focus_recursive(tag->frame);
     monitor_restack(monitor);
@@ -1345,7 +1456,7 @@ void monitor_restack(HSMonitor* monitor) {
         memmove(buf + idx, buf + idx + 1, sizeof(*buf) * (count - idx));
     }
     DesktopWindow::lowerDesktopWindows();
-    XRestackWindows(g_display, buf, count);
+    stack_restack_buf(monitor->tag->stack, buf, count, true);
     g_free(buf);
 }
 
@@ -32,12 +32,40 @@ static bool             g_drag_init_done;
 static HSClient*        g_win_drag_client = NULL;
 static HSMonitor*       g_drag_monitor = NULL;
 static MouseDragFunction g_drag_function = NULL;
+// the newest motion that was not applied yet because of drag_fps
+static XMotionEvent     g_drag_pending_motion;
+static bool             g_drag_pending = false;
+static long long        g_drag_last_update; // in milliseconds
+// number of motion events of the current drag that were superseded by newer
+// ones before they were handled
+static unsigned long    g_drag_skipped_motions;
+
+// an edge of another client the dragged client can snap to. The edge is at
+// pos and spans the interval [begin, end) in the other dimension
+typedef struct {
+    int pos;
+    int begin;
+    int end;
+} SnapEdge;
+// the edges of all other clients of the drag, sorted by pos
+enum {
+    SNAP_INDEX_LEFT,    // left edges, the subject's right edge snaps to
+    SNAP_INDEX_RIGHT,
+    SNAP_INDEX_TOP,
+    SNAP_INDEX_BOTTOM,
+    SNAP_INDEX_COUNT,
+};
+static GArray*          g_snap_edges[SNAP_INDEX_COUNT]; // of SnapEdge
+static void snap_index_build(HSClient* client, HSTag* tag);
 
 static Cursor g_cursor;
 static GList* g_mouse_binds = NULL;
+// incremented whenever g_mouse_binds changes
+static int g_mouse_binds_generation = 1;
 static unsigned int* g_numlockmask_ptr;
 static int* g_snap_distance;
 static int* g_snap_gap;
+static int* g_drag_fps;
 
 #define CLEANMASK(mask)         ((mask) & ~(*g_numlockmask_ptr|LockMask))
 #define REMOVEBUTTONMASK(mask) ((mask) & \
@@ -51,6 +79,10 @@ void mouse_init() {
     g_numlockmask_ptr = get_numlockmask_ptr();
     g_snap_distance = &(settings_find("snap_distance")->value.i);
     g_snap_gap = &(settings_find("snap_gap")->value.i);
+    g_drag_fps = &(settings_find("drag_fps")->value.i);
+    for (int i = 0; i < SNAP_INDEX_COUNT; i++) {
+        g_snap_edges[i] = g_array_new(false, false, sizeof(SnapEdge));
+    }
     /* set cursor theme */
     g_cursor = XCreateFontCursor(g_display, XC_left_ptr);
     XDefineCursor(g_display, g_root, g_cursor);
@@ -59,6 +91,9 @@ void mouse_init() {
 void mouse_destroy() {
     mouse_unbind_all();
     XFreeCursor(g_display, g_cursor);
+    for (int i = 0; i < SNAP_INDEX_COUNT; i++) {
+        g_array_free(g_snap_edges[i], true);
+    }
 }
 
 void mouse_handle_event(XEvent* ev) {
@@ -115,13 +150,23 @@ void mouse_initiate_drag(HSClient* client, MouseDragFunction function) {
     g_win_drag_start = g_win_drag_client->float_size;
     g_button_drag_start = get_cursor_position();
     g_drag_init_done = false;
+    g_drag_pending = false;
+    g_drag_last_update = 0;
+    g_drag_skipped_motions = 0;
+    snap_index_build(client, g_drag_monitor->tag);
     XGrabPointer(g_display, client->window, True,
         PointerMotionMask|ButtonReleaseMask, GrabModeAsync,
             GrabModeAsync, None, None, CurrentTime);
 }
 
 void mouse_stop_drag() {
+    if (g_win_drag_client && g_drag_pending) {
+        // the final position must not get lost
+        g_drag_pending = false;
+        g_drag_function(&g_drag_pending_motion);
+    }
     if (g_win_drag_client) {
+        HSDebug("drag: skipped %lu motion events\n", g_drag_skipped_motions);
         client_set_dragged(g_win_drag_client, false);
         // resend last size
         monitor_apply_layout(g_drag_monitor);
@@ -141,12 +186,56 @@ void handle_motion_event(XEvent* ev) {
     if (!g_win_drag_client) return;
     if (!g_drag_function) return;
     if (ev->type != MotionNotify) return;
-    // get newest motion notification
-    while (XCheckMaskEvent(g_display, ButtonMotionMask, ev));
+    // only handle the newest of the queued motions of the drag window, but
+    // do not skip over other events, e.g. the button release
+    XEvent next;
+    while (XEventsQueued(g_display, QueuedAfterReading) > 0) {
+        XPeekEvent(g_display, &next);
+        if (next.type != MotionNotify
+            || next.xmotion.window != ev->xmotion.window) {
+            break;
+        }
+        XNextEvent(g_display, ev);
+        g_drag_skipped_motions++;
+    }
+    if (*g_drag_fps > 0) {
+        // only remember the target, it is applied once the frame is due
+        g_drag_pending_motion = ev->xmotion;
+        g_drag_pending = true;
+        mouse_drag_tick();
+        return;
+    }
     // call function that handles it
     g_drag_function(&(ev->xmotion));
 }
 
+void mouse_drag_tick() {
+    if (!g_win_drag_client || !g_drag_pending) {
+        return;
+    }
+    long long now = get_monotonic_msec();
+    if (*g_drag_fps > 0 && now - g_drag_last_update < 1000 / *g_drag_fps) {
+        return;
+    }
+    g_drag_last_update = now;
+    g_drag_pending = false;
+    g_drag_function(&g_drag_pending_motion);
+}
+
+bool mouse_drag_timeout(struct timeval* timeout) {
+    if (!g_win_drag_client || !g_drag_pending) {
+        return false;
+    }
+    long long wait = 0;
+    if (*g_drag_fps > 0) {
+        wait = g_drag_last_update + 1000 / *g_drag_fps - get_monotonic_msec();
+        wait = MAX(wait, 0);
+    }
+    timeout->tv_sec = wait / 1000;
+    timeout->tv_usec = (wait % 1000) * 1000;
+    return true;
+}
+
 bool mouse_is_dragging() {
     return g_drag_function != NULL;
 }
@@ -161,6 +250,7 @@ static void mouse_binding_free(void* voidmb) {
 int mouse_unbind_all() {
     g_list_free_full(g_mouse_binds, mouse_binding_free);
     g_mouse_binds = NULL;
+    g_mouse_binds_generation++;
     HSClient* client = get_current_client();
     if (client) {
         grab_client_buttons(client, true);
@@ -212,6 +302,7 @@ int mouse_bind_command(int argc, char** argv, GString* output) {
     mb->argc = argc - 3;
     mb->argv = argv_duplicate(argc - 3, argv + 3);;
     g_mouse_binds = g_list_prepend(g_mouse_binds, mb);
+    g_mouse_binds_generation++;
     HSClient* client = get_current_client();
     if (client) {
         grab_client_buttons(client, true);
@@ -290,7 +381,16 @@ static void grab_client_button(MouseBinding* bind, HSClient* client) {
 }
 
 void grab_client_buttons(HSClient* client, bool focused) {
-    update_numlockmask();
+    // the numlockmask is kept up to date by regrab_keys()
+    if (client->grabbed_generation == g_mouse_binds_generation
+        && client->grabbed_focused == focused
+        && client->grabbed_numlockmask == *g_numlockmask_ptr) {
+        // the window has exactly these grabs already
+        return;
+    }
+    client->grabbed_generation = g_mouse_binds_generation;
+    client->grabbed_focused = focused;
+    client->grabbed_numlockmask = *g_numlockmask_ptr;
     XUngrabButton(g_display, AnyButton, AnyModifier, client->window);
     if (focused) {
         g_list_foreach(g_mouse_binds, (GFunc)grab_client_button, client);
@@ -325,9 +425,7 @@ void mouse_function_resize_tiled(XMotionEvent* me) {
         g_drag_init_done = true;
         /* initialize local state */
         HSClient* client = g_win_drag_client;
-        HSTag* tag = client->tag;
-        HSFrame* root = tag->frame;
-        HSFrame* frame = find_frame_with_client(root, client);
+        HSFrame* frame = client->frame;
         Rectangle* rect = &frame->last_rect;
 
         // relative x/y coords in drag window
@@ -415,6 +513,7 @@ void mouse_function_resize_tiled(XMotionEvent* me) {
                 (int)(FRAME_MIN_FRACTION * FRACTION_UNIT),
                 (int)((1.0 - FRAME_MIN_FRACTION) * FRACTION_UNIT));
 
+    frame_set_dirty(parent);
     frame_apply_layout(parent, parent->last_rect);
 }
 
@@ -535,9 +634,7 @@ void mouse_function_zoom(XMotionEvent* me) {
 }
 
 struct SnapData {
-    HSClient*       client;
-    Rectangle      rect;
-    enum SnapFlags  flags;
+    Rectangle       rect;
     int             dx, dy; // the vector from client to other to make them snap
 };
 
@@ -561,38 +658,69 @@ static void snap_1d(int x, int edge, int* delta) {
     }
 }
 
-static int client_snap_helper(HSClient* candidate, struct SnapData* d) {
-    if (candidate == d->client) {
+static int snap_index_add(HSClient* candidate, HSClient* client) {
+    if (candidate == client) {
         return 0;
     }
-    Rectangle subject  = d->rect;
-    Rectangle other    = candidate->dec.last_outer_rect;
+    Rectangle other = candidate->dec.last_outer_rect;
     // increase other by snap gap
     other.x -= *g_snap_gap;
     other.y -= *g_snap_gap;
     other.width += *g_snap_gap * 2;
     other.height += *g_snap_gap * 2;
-    if (intervals_intersect(other.y, other.y + other.height, subject.y, subject.y + subject.height)) {
-        // check if x can snap to the right
-        if (d->flags & SNAP_EDGE_RIGHT) {
-            snap_1d(subject.x + subject.width, other.x, &d->dx);
-        }
-        // or to the left
-        if (d->flags & SNAP_EDGE_LEFT) {
-            snap_1d(subject.x, other.x + other.width, &d->dx);
+    int top = other.y, bottom = other.y + other.height;
+    int left = other.x, right = other.x + other.width;
+    SnapEdge edges[SNAP_INDEX_COUNT] = {
+        { left,     top,    bottom  }, // SNAP_INDEX_LEFT
+        { right,    top,    bottom  }, // SNAP_INDEX_RIGHT
+        { top,      left,   right   }, // SNAP_INDEX_TOP
+        { bottom,   left,   right   }, // SNAP_INDEX_BOTTOM
+    };
+    for (int i = 0; i < SNAP_INDEX_COUNT; i++) {
+        g_array_append_val(g_snap_edges[i], edges[i]);
+    }
+    return 0;
+}
+
+static int snap_edge_compare(const void* a, const void* b) {
+    return ((const SnapEdge*)a)->pos - ((const SnapEdge*)b)->pos;
+}
+
+// collects the edges of the other clients once per drag, they do not move
+// while the client is dragged
+static void snap_index_build(HSClient* client, HSTag* tag) {
+    for (int i = 0; i < SNAP_INDEX_COUNT; i++) {
+        g_array_set_size(g_snap_edges[i], 0);
+    }
+    frame_foreach_client(tag->frame, (ClientAction)snap_index_add, client);
+    for (int i = 0; i < SNAP_INDEX_COUNT; i++) {
+        g_array_sort(g_snap_edges[i], snap_edge_compare);
+    }
+}
+
+// snap x to the edges of the index within the current delta, if the edge's
+// interval intersects [begin, end)
+static void snap_to_index(int index, int x, int begin, int end, int* delta) {
+    GArray* edges = g_snap_edges[index];
+    // find the first edge with pos > x - |delta|
+    int lo = 0, hi = edges->len;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (g_array_index(edges, SnapEdge, mid).pos <= x - abs(*delta)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
-    if (intervals_intersect(other.x, other.x + other.width, subject.x, subject.x + subject.width)) {
-        // if we can snap to the top
-        if (d->flags & SNAP_EDGE_TOP) {
-            snap_1d(subject.y, other.y + other.height, &d->dy);
+    for (int i = lo; i < edges->len; i++) {
+        SnapEdge* e = &g_array_index(edges, SnapEdge, i);
+        if (e->pos >= x + abs(*delta)) {
+            break;
         }
-        // or to the bottom
-        if (d->flags & SNAP_EDGE_BOTTOM) {
-            snap_1d(subject.y + subject.height, other.y, &d->dy);
+        if (intervals_intersect(e->begin, e->end, begin, end)) {
+            snap_1d(x, e->pos, delta);
         }
     }
-    return 0;
 }
 
 // get the vector to snap a client to it's neighbour
@@ -600,7 +728,6 @@ void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
                         enum SnapFlags flags,
                         int* return_dx, int* return_dy) {
     struct SnapData d;
-    HSTag* tag = monitor->tag;
     int distance = (*g_snap_distance > 0) ? *g_snap_distance : 0;
     // init delta
     *return_dx = 0;
@@ -609,12 +736,10 @@ void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
         // nothing to do
         return;
     }
-    d.client    = client;
     // translate client rectangle to global coordinates
     d.rect      = client_outer_floating_rect(client);
     d.rect.x += monitor->rect.x + monitor->pad_left;
     d.rect.y += monitor->rect.y + monitor->pad_up;
-    d.flags     = flags;
     d.dx        = distance;
     d.dy        = distance;
 
@@ -634,7 +759,19 @@ void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
     }
 
     // snap to other clients
-    frame_foreach_client(tag->frame, (ClientAction)client_snap_helper, &d);
+    Rectangle r = d.rect;
+    if (flags & SNAP_EDGE_RIGHT) {
+        snap_to_index(SNAP_INDEX_LEFT, r.x + r.width, r.y, r.y + r.height, &d.dx);
+    }
+    if (flags & SNAP_EDGE_LEFT) {
+        snap_to_index(SNAP_INDEX_RIGHT, r.x, r.y, r.y + r.height, &d.dx);
+    }
+    if (flags & SNAP_EDGE_TOP) {
+        snap_to_index(SNAP_INDEX_BOTTOM, r.y, r.x, r.x + r.width, &d.dy);
+    }
+    if (flags & SNAP_EDGE_BOTTOM) {
+        snap_to_index(SNAP_INDEX_TOP, r.y + r.height, r.x, r.x + r.width, &d.dy);
+    }
 
     // write back results
     if (abs(d.dx) < abs(distance)) {
@@ -8,6 +8,7 @@
 
 #include <X11/Xlib.h>
 #include <stdbool.h>
+#include <sys/time.h>
 #include "glib-backports.h"
 
 // various snap-flags
@@ -57,6 +58,11 @@ void mouse_initiate_drag(struct HSClient* client, MouseDragFunction function);
 void mouse_stop_drag();
 bool mouse_is_dragging();
 void handle_motion_event(XEvent* ev);
+// applies the newest motion of the drag, if drag_fps allows it already
+void mouse_drag_tick();
+// tells how long to wait for the next mouse_drag_tick(). Returns false if
+// there is nothing to apply
+bool mouse_drag_timeout(struct timeval* timeout);
 
 // get the vector to snap a client to it's neighbour
 void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
@@ -11,6 +11,7 @@
 #include "utils.h"
 #include "ewmh.h"
 #include "object.h"
+#include "decoration.h"
 
 #include "glib-backports.h"
 #include <string.h>
@@ -56,6 +57,7 @@ SettingsPair SET_COMPAT(const char* name, const char* read, const char* write)
 #define LOCK_CHANGED monitors_lock_changed
 #define FOCUS_LAYER tag_update_each_focus_layer
 #define WMNAME ewmh_update_wmname
+#define DECORATIONS decorations_redraw_all
 
 // default settings:
 SettingsPair g_settings[] = {
@@ -94,6 +96,9 @@ SettingsPair g_settings[] = {
     SET_INT(    "auto_detect_monitors",            0,           NULL          ),
     SET_INT(    "pseudotile_center_threshold",    10,           RELAYOUT      ),
     SET_INT(    "update_dragged_clients",          0,           NULL          ),
+    SET_INT(    "drag_fps",                        0,           NULL          ),
+    SET_INT(    "decoration_pixmaps",              0,           DECORATIONS   ),
+    SET_INT(    "layout_threads",                  0,           NULL          ),
     SET_STRING( "tree_style",                      "*| +`--.",  reload_tree_style),
     SET_STRING( "wmname",                  WINDOW_MANAGER_NAME, WMNAME        ),
     // settings for compatibility:
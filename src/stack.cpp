@@ -21,15 +21,47 @@ const std::array<const char*, LAYER_COUNT>g_layer_names =
      { LAYER_FRAMES      , "Frame Layer"      },
 }).a;
 
+// incremented whenever the applied order of all stacks becomes invalid
+static int g_stack_generation = 0;
+
+static void stack_invalidate_windows(HSStack* stack) {
+    stack->windows_valid = false;
+}
+
+/* slice pool
+ * slices are allocated in chunks of SLICE_POOL_CHUNK_SIZE slices. Unused
+ * slices are kept in a free list, which is linked via data.next_free.
+ */
+#define SLICE_POOL_CHUNK_SIZE 32
+
+typedef struct HSSliceChunk {
+    struct HSSliceChunk* next;
+    HSSlice slices[SLICE_POOL_CHUNK_SIZE];
+} HSSliceChunk;
+
+static HSSliceChunk*    g_slice_chunks;
+static HSSlice*         g_free_slices;
+
 void stacklist_init() {
 }
 
 void stacklist_destroy() {
+    while (g_slice_chunks) {
+        HSSliceChunk* next = g_slice_chunks->next;
+        g_free(g_slice_chunks);
+        g_slice_chunks = next;
+    }
+    g_free_slices = NULL;
 }
 
 
 HSStack* stack_create() {
-    return g_new0(HSStack, 1);
+    HSStack* s = g_new0(HSStack, 1);
+    s->applied = g_array_new(false, false, sizeof(Window));
+    s->windows[0] = g_array_new(false, false, sizeof(Window));
+    s->windows[1] = g_array_new(false, false, sizeof(Window));
+    s->applied_generation = -1;
+    return s;
 }
 
 void stack_destroy(HSStack* s) {
@@ -39,11 +71,25 @@ void stack_destroy(HSStack* s) {
                     g_layer_names[i], (void*)s);
         }
     }
+    g_array_free(s->applied, true);
+    g_array_free(s->windows[0], true);
+    g_array_free(s->windows[1], true);
     g_free(s);
 }
 
 static HSSlice* slice_create() {
-    HSSlice* s = g_new0(HSSlice, 1);
+    if (!g_free_slices) {
+        HSSliceChunk* chunk = g_new(HSSliceChunk, 1);
+        chunk->next = g_slice_chunks;
+        g_slice_chunks = chunk;
+        for (int i = 0; i < SLICE_POOL_CHUNK_SIZE; i++) {
+            chunk->slices[i].data.next_free = g_free_slices;
+            g_free_slices = chunk->slices + i;
+        }
+    }
+    HSSlice* s = g_free_slices;
+    g_free_slices = s->data.next_free;
+    memset(s, 0, sizeof(*s));
     s->layer[0] = LAYER_NORMAL;
     s->layer_count = 1;
     return s;
@@ -78,7 +124,8 @@ HSSlice* slice_create_monitor(HSMonitor* monitor) {
 }
 
 void slice_destroy(HSSlice* slice) {
-    g_free(slice);
+    slice->data.next_free = g_free_slices;
+    g_free_slices = slice;
 }
 
 HSLayer slice_highest_layer(HSSlice* slice) {
@@ -91,20 +138,51 @@ HSLayer slice_highest_layer(HSSlice* slice) {
     return highest;
 }
 
+// inserts the slice at the top of the layer
+static void layer_push(HSStack* stack, HSLayer layer, HSSlice* slice) {
+    slice->above[layer] = NULL;
+    slice->below[layer] = stack->top[layer];
+    if (stack->top[layer]) {
+        stack->top[layer]->above[layer] = slice;
+    } else {
+        stack->bottom[layer] = slice;
+    }
+    stack->top[layer] = slice;
+}
+
+// removes the slice from the layer, which must contain it
+static void layer_unlink(HSStack* stack, HSLayer layer, HSSlice* slice) {
+    if (slice->above[layer]) {
+        slice->above[layer]->below[layer] = slice->below[layer];
+    } else {
+        stack->top[layer] = slice->below[layer];
+    }
+    if (slice->below[layer]) {
+        slice->below[layer]->above[layer] = slice->above[layer];
+    } else {
+        stack->bottom[layer] = slice->above[layer];
+    }
+    slice->above[layer] = NULL;
+    slice->below[layer] = NULL;
+}
+
 void stack_insert_slice(HSStack* s, HSSlice* elem) {
     for (int i = 0; i < elem->layer_count; i++) {
-        int layer = elem->layer[i];
-        s->top[layer] = g_list_prepend(s->top[layer], elem);
+        layer_push(s, elem->layer[i], elem);
     }
     s->dirty = true;
+    stack_invalidate_windows(s);
+    // the window may have been restacked as part of another stack
+    s->applied_generation = -1;
 }
 
 void stack_remove_slice(HSStack* s, HSSlice* elem) {
     for (int i = 0; i < elem->layer_count; i++) {
-        int layer = elem->layer[i];
-        s->top[layer] = g_list_remove(s->top[layer], elem);
+        layer_unlink(s, elem->layer[i], elem);
     }
     s->dirty = true;
+    stack_invalidate_windows(s);
+    s->applied_generation = -1;
 }
 
 static void slice_append_caption(HSTree root, GString* output) {
@@ -156,7 +234,10 @@ struct TmpLayer {
 
 static struct HSTreeInterface layer_nth_child(HSTree root, size_t idx) {
     struct TmpLayer* l = (struct TmpLayer*) root;
-    HSSlice* slice = (HSSlice*) g_list_nth_data(l->stack->top[l->layer], idx);
+    HSSlice* slice = l->stack->top[l->layer];
+    while (idx--) {
+        slice = slice->below[l->layer];
+    }
     HSTreeInterface intface = {
         /* .nth_child      = */ slice_nth_child,
         /* .child_count    = */ slice_child_count,
@@ -169,7 +250,11 @@ static struct HSTreeInterface layer_nth_child(HSTree root, size_t idx) {
 
 static size_t layer_child_count(HSTree root) {
     struct TmpLayer* l = (struct TmpLayer*) root;
-    return g_list_length(l->stack->top[l->layer]);
+    size_t count = 0;
+    for (HSSlice* s = l->stack->top[l->layer]; s; s = s->below[l->layer]) {
+        count++;
+    }
+    return count;
 }
 
 static void layer_append_caption(HSTree root, GString* output) {
@@ -217,23 +302,16 @@ int print_stack_command(int argc, char** argv, GString* output) {
     return 0;
 }
 
-int stack_window_count(HSStack* stack, bool real_clients) {
-    int counter = 0;
-    stack_to_window_buf(stack, NULL, 0, real_clients, &counter);
-    return -counter;
-}
-
-/* stack to window buf */
+/* flattened window lists of a stack */
 struct s2wb {
-    int     len;
-    Window* buf;
-    int     missing; /* number of slices that could not find space in buf */
-    bool    real_clients; /* whether to include windows that aren't clients */
+    GArray* windows[2]; /* without and with real clients */
+    bool    cacheable;  /* false if it contains windows of other stacks */
     HSLayer layer;  /* the layer the slice should be added to */
 };
 
+static GArray* stack_windows(HSStack* stack, bool real_clients);
+
 static void slice_to_window_buf(HSSlice* s, struct s2wb* data) {
-    HSTag* tag;
     if (slice_highest_layer(s) != data->layer) {
         /** slice only is added to its highest layer.
          * just skip it if the slice is not shown on this data->layer */
@@ -241,99 +319,204 @@ static void slice_to_window_buf(HSSlice* s, struct s2wb* data) {
     }
     switch (s->type) {
         case SLICE_CLIENT:
-            if (data->len) {
-                if (data->real_clients) {
-                    data->buf[0] = s->data.client->window;
-                } else {
-                    data->buf[0] = s->data.client->dec.decwin;
-                }
-                data->buf++;
-                data->len--;
-            } else {
-                data->missing++;
-            }
+            g_array_append_val(data->windows[0], s->data.client->dec.decwin);
+            g_array_append_val(data->windows[1], s->data.client->window);
             break;
         case SLICE_WINDOW:
-            if (!data->real_clients) {
-                if (data->len) {
-                    data->buf[0] = s->data.window;
-                    data->buf++;
-                    data->len--;
-                } else {
-                    data->missing++;
-                }
-            }
+            g_array_append_val(data->windows[0], s->data.window);
             break;
         case SLICE_MONITOR:
-            tag = s->data.monitor->tag;
-            if (!data->real_clients) {
-                if (data->len) {
-                    data->buf[0] = s->data.monitor->stacking_window;
-                    data->buf++;
-                    data->len--;
-                } else {
-                    data->missing++;
-                }
-            }
-            int remain_len = 0; /* remaining length */
-            stack_to_window_buf(tag->stack, data->buf, data->len,
-                                data->real_clients, &remain_len);
-            int len_used = data->len - remain_len;
-            if (remain_len >= 0) {
-                data->buf += len_used;
-                data->len = remain_len;
-            } else {
-                data->len = 0;
-                data->missing += -remain_len;
+            g_array_append_val(data->windows[0],
+                               s->data.monitor->stacking_window);
+            for (int i = 0; i < 2; i++) {
+                GArray* tag_windows = stack_windows(s->data.monitor->tag->stack,
+                                                    i != 0);
+                g_array_append_vals(data->windows[i], tag_windows->data,
+                                    tag_windows->len);
             }
+            // the tag of the monitor and its stack may change at any time
+            data->cacheable = false;
             break;
     }
 }
 
+// returns the windows of the stack from top to bottom. The list is rebuilt
+// only if the stack changed.
+static GArray* stack_windows(HSStack* stack, bool real_clients) {
+    if (!stack->windows_valid) {
+        struct s2wb data;
+        data.windows[0] = stack->windows[0];
+        data.windows[1] = stack->windows[1];
+        data.cacheable = true;
+        g_array_set_size(data.windows[0], 0);
+        g_array_set_size(data.windows[1], 0);
+        for (int i = 0; i < LAYER_COUNT; i++) {
+            data.layer = (HSLayer)i;
+            for (HSSlice* s = stack->top[i]; s; s = s->below[i]) {
+                slice_to_window_buf(s, &data);
+            }
+        }
+        stack->windows_valid = data.cacheable;
+    }
+    return stack->windows[real_clients ? 1 : 0];
+}
+
+int stack_window_count(HSStack* stack, bool real_clients) {
+    return stack_windows(stack, real_clients)->len;
+}
+
 void stack_to_window_buf(HSStack* stack, Window* buf, int len,
                          bool real_clients, int* remain_len) {
-    struct s2wb data = {
-        /* .len = */ len,
-        /* .buf = */ buf,
-        /* .missing = */ 0,
-        /* .real_clients = */ real_clients,
-    };
-    for (int i = 0; i < LAYER_COUNT; i++) {
-        data.layer = (HSLayer)i;
-        g_list_foreach(stack->top[i], (GFunc)slice_to_window_buf, &data);
+    GArray* windows = stack_windows(stack, real_clients);
+    int count = windows->len;
+    if (buf) {
+        memcpy(buf, windows->data, sizeof(Window) * MIN(len, count));
     }
     if (!remain_len) {
         // nothing to do
         return;
     }
-    if (data.missing == 0) {
-        *remain_len = data.len;
-    } else {
-        *remain_len = -data.missing;
+    // the remaining length, or the number of windows that did not fit
+    *remain_len = (count <= len) ? (len - count) : -(count - len);
+}
+
+typedef struct {
+    Window  window;
+    int     index;
+} HSWindowIndex;
+
+static int window_index_compare(const void* a, const void* b) {
+    Window wa = ((const HSWindowIndex*)a)->window;
+    Window wb = ((const HSWindowIndex*)b)->window;
+    return (wa < wb) ? -1 : (wa > wb);
+}
+
+// sends the XConfigureWindow() calls that are needed to get from the order
+// in applied to the order in buf. Returns false without sending anything if
+// not enough is known about the current order.
+static bool restack_minimal(GArray* applied, Window* buf, int count) {
+    // the position of each window in the applied order
+    HSWindowIndex* index = g_new(HSWindowIndex, applied->len);
+    for (int i = 0; i < applied->len; i++) {
+        index[i].window = g_array_index(applied, Window, i);
+        index[i].index = i;
+    }
+    qsort(index, applied->len, sizeof(*index), window_index_compare);
+    int* pos = g_new(int, count);
+    for (int i = 0; i < count; i++) {
+        HSWindowIndex key = { buf[i], 0 };
+        HSWindowIndex* found = (HSWindowIndex*)bsearch(&key, index,
+            applied->len, sizeof(*index), window_index_compare);
+        pos[i] = found ? found->index : -1;
     }
+    g_free(index);
+    // the windows on a longest increasing subsequence of positions already
+    // are in the right order and are not moved.
+    // tail[k] is the end of the best subsequence of length k+1 found so far
+    int* tail = g_new(int, count);
+    int* prev = g_new(int, count);
+    bool* keep = g_new0(bool, count);
+    int length = 0;
+    for (int i = 0; i < count; i++) {
+        if (pos[i] < 0) {
+            continue;
+        }
+        int lo = 0, hi = length;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (pos[tail[mid]] < pos[i]) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        prev[i] = (lo > 0) ? tail[lo - 1] : -1;
+        tail[lo] = i;
+        length = MAX(length, lo + 1);
+    }
+    for (int i = length ? tail[length - 1] : -1; i >= 0; i = prev[i]) {
+        keep[i] = true;
+    }
+    int first_kept = 0;
+    while (first_kept < count && !keep[first_kept]) {
+        first_kept++;
+    }
+    bool known = first_kept < count;
+    if (known) {
+        // place the other windows next to a neighbour, that already is
+        // at its final position
+        XWindowChanges wc;
+        wc.stack_mode = Above;
+        for (int i = first_kept - 1; i >= 0; i--) {
+            wc.sibling = buf[i + 1];
+            XConfigureWindow(g_display, buf[i], CWSibling | CWStackMode, &wc);
+        }
+        wc.stack_mode = Below;
+        for (int i = first_kept + 1; i < count; i++) {
+            if (!keep[i]) {
+                wc.sibling = buf[i - 1];
+                XConfigureWindow(g_display, buf[i],
+                                 CWSibling | CWStackMode, &wc);
+            }
+        }
+    }
+    g_free(pos);
+    g_free(tail);
+    g_free(prev);
+    g_free(keep);
+    return known;
+}
+
+void stack_restack_buf(HSStack* stack, Window* buf, int count,
+                       bool keep_first) {
+    HSStack* monitor_stack = get_monitor_stack();
+    // the applied order never contains the kept window, such that it is the
+    // same no matter if a stack is restacked with or without its monitor's
+    // stacking window. The stack's windows stay directly below that
+    // window, as long as they are only moved relative to each other.
+    Window* windows = keep_first ? buf + 1 : buf;
+    int window_count = keep_first ? count - 1 : count;
+    bool usable = stack->applied_generation == g_stack_generation
+                  && (stack->applied_anchored || !keep_first);
+    bool minimal = usable && window_count >= 2
+                   && restack_minimal(stack->applied, windows, window_count);
+    if (!minimal) {
+        XRestackWindows(g_display, buf, count);
+    }
+    stack->applied_anchored = keep_first || (stack->applied_anchored && minimal);
+    if (stack == monitor_stack) {
+        // this reorders the windows of all tag stacks
+        g_stack_generation++;
+    } else if (monitor_stack) {
+        monitor_stack->applied_generation = -1;
+    }
+    g_array_set_size(stack->applied, 0);
+    g_array_append_vals(stack->applied, windows, window_count);
+    stack->applied_generation = g_stack_generation;
+}
+
+void stack_forget_applied_orders() {
+    g_stack_generation++;
 }
 
 void stack_restack(HSStack* stack) {
     if (!stack->dirty) {
         return;
     }
-    int count = stack_window_count(stack, false);
-    Window* buf = g_new0(Window, count);
-    stack_to_window_buf(stack, buf, count, false, NULL);
-    XRestackWindows(g_display, buf, count);
+    GArray* windows = stack_windows(stack, false);
+    stack_restack_buf(stack, (Window*)windows->data, windows->len, false);
     stack->dirty = false;
     ewmh_update_client_list_stacking();
-    g_free(buf);
 }
 
 void stack_raise_slide(HSStack* stack, HSSlice* slice) {
     for (int i = 0; i < slice->layer_count; i++) {
-        // remove slice from list
-        stack->top[slice->layer[i]] = g_list_remove(stack->top[slice->layer[i]], slice);
-        // and insert it again at the top
-        stack->top[slice->layer[i]] = g_list_prepend(stack->top[slice->layer[i]], slice);
+        // move the slice to the top of each of its layers
+        layer_unlink(stack, slice->layer[i], slice);
+        layer_push(stack, slice->layer[i], slice);
     }
     stack->dirty = true;
+    stack_invalidate_windows(stack);
     // TODO: maybe only update the specific range and not the entire stack
     // update
     stack_restack(stack);
@@ -341,6 +524,7 @@ void stack_raise_slide(HSStack* stack, HSSlice* slice) {
 
 void stack_mark_dirty(HSStack* s) {
     s->dirty = true;
+    stack_invalidate_windows(s);
 }
 
 void stack_slice_add_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
@@ -352,8 +536,9 @@ void stack_slice_add_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
     }
     slice->layer[slice->layer_count] = layer;
     slice->layer_count++;
-    stack->top[layer] = g_list_prepend(stack->top[layer], slice);
+    layer_push(stack, layer, slice);
     stack->dirty = true;
+    stack_invalidate_windows(stack);
 }
 
 void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
@@ -363,14 +548,15 @@ void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
             break;
         }
     }
-    /* remove slice from layer in the stack */
-    stack->top[layer] = g_list_remove(stack->top[layer], slice);
-    stack->dirty = true;
     if (i >= slice->layer_count) {
         HSDebug("remove layer: slice %p not in %s\n", (void*)slice,
                 g_layer_names[layer]);
         return;
     }
+    /* remove slice from layer in the stack */
+    layer_unlink(stack, layer, slice);
+    stack->dirty = true;
+    stack_invalidate_windows(stack);
     /* remove layer in slice */
     slice->layer_count--;
     size_t len = sizeof(HSLayer) * (slice->layer_count - i);
@@ -379,9 +565,7 @@ void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
 
 Window stack_lowest_window(HSStack* stack) {
     for (int i = LAYER_COUNT - 1; i >= 0; i--) {
-        GList* last = g_list_last(stack->top[i]);
-        while (last) {
-            HSSlice* slice = (HSSlice*)last->data;
+        for (HSSlice* slice = stack->bottom[i]; slice; slice = slice->above[i]) {
             Window w = 0;
             switch (slice->type) {
                 case SLICE_CLIENT:
@@ -397,7 +581,6 @@ Window stack_lowest_window(HSStack* stack) {
             if (w) {
                 return w;
             }
-            last = g_list_previous(last);
         }
     }
     // if no window was found
@@ -410,7 +593,7 @@ bool stack_is_layer_empty(HSStack* s, HSLayer layer) {
 
 void stack_clear_layer(HSStack* stack, HSLayer layer) {
     while (!stack_is_layer_empty(stack, layer)) {
-        HSSlice* slice = (HSSlice*)stack->top[layer]->data;
+        HSSlice* slice = stack->top[layer];
         stack_slice_remove_layer(stack, slice, layer);
         stack->dirty = true;
     }
@@ -35,16 +35,26 @@ typedef struct HSSlice {
     HSSliceType type;
     HSLayer     layer[LAYER_COUNT]; /* layers this slice is contained in */
     size_t      layer_count;        /* count of those layers */
+    /* neighbours within each layer of the stack, indexed by HSLayer */
+    struct HSSlice* above[LAYER_COUNT];
+    struct HSSlice* below[LAYER_COUNT];
     union {
         struct HSClient*    client;
         Window              window;
         struct HSMonitor*   monitor;
+        struct HSSlice*     next_free; /* in the slice pool */
     } data;
 } HSSlice;
 
 typedef struct HSStack {
-    GList*  top[LAYER_COUNT];
+    HSSlice* top[LAYER_COUNT];
+    HSSlice* bottom[LAYER_COUNT];
     bool    dirty;  /* stacking order changed but it wasn't restacked yet */
+    GArray* applied; /* windows in the order last sent to the X server */
+    int     applied_generation; /* applied is outdated if this differs */
+    bool    applied_anchored; /* applied is directly below the stacking window */
+    GArray* windows[2]; /* flattened windows, without and with clients */
+    bool    windows_valid; /* whether windows is up to date */
 } HSStack;
 
 void stacklist_init();
@@ -73,6 +83,14 @@ int stack_window_count(HSStack* stack, bool real_clients);
 void stack_to_window_buf(HSStack* stack, Window* buf, int len, bool real_clients,
                          int* remain_len);
 void stack_restack(HSStack* stack);
+// restacks the windows of buf (from top to bottom) but only moves those
+// windows which are not in the right order already. If keep_first is set,
+// buf[0] is the stacking window of a monitor and is not moved, like in
+// XRestackWindows()
+void stack_restack_buf(HSStack* stack, Window* buf, int count,
+                       bool keep_first);
+// forget all stacking orders, e.g. if a window was restacked directly
+void stack_forget_applied_orders();
 Window stack_lowest_window(HSStack* stack);
 
 HSStack* stack_create();
@@ -19,6 +19,7 @@
 #include "ewmh.h"
 #include "monitor.h"
 #include "settings.h"
+#include "floating.h"
 
 static GArray*     g_tags; // Array of HSTag*
 static bool    g_tag_flags_dirty = true;
@@ -50,6 +51,14 @@ static void tag_free(HSTag* tag) {
             g_free(buf);
         }
     }
+    frame_index_destroy(tag->frame_index);
+    floating_index_destroy(tag->floating_index);
+    for (int i = 0; i < LENGTH(tag->layout_cache); i++) {
+        if (tag->layout_cache[i]) {
+            g_string_free(tag->layout_cache[i], true);
+        }
+    }
+    frame_pool_destroy(tag->frame_pool);
     stack_destroy(tag->stack);
     hsobject_unlink_and_destroy(g_tag_by_name, tag->object);
     g_string_free(tag->name, true);
@@ -227,6 +236,7 @@ HSTag* add_tag(const char* name) {
     }
     HSTag* tag = g_new0(HSTag, 1);
     tag->stack = stack_create();
+    tag->frame_pool = frame_pool_create();
     tag->frame = frame_create_empty(NULL, tag);
     tag->name = g_string_new(name);
     tag->display_name = g_string_new(name);
@@ -347,6 +357,7 @@ int tag_remove_command(int argc, char** argv, GString* output) {
     int i;
     for (i = 0; i < count; i++) {
         HSClient* client = buf[i];
+        client->frame = NULL;
         stack_remove_slice(client->tag->stack, client->slice);
         client->tag = target;
         stack_insert_slice(client->tag->stack, client->slice);
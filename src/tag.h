@@ -17,6 +17,13 @@ typedef struct HSTag {
     GString*        name;   // name of this tag
     GString*        display_name; // name used for object-io
     struct HSFrame* frame;  // the master frame
+    struct HSFramePool* frame_pool; // memory for the frames of this tag
+    struct HSFrameIndex* frame_index; // for frame_neighbour(), may be NULL
+    struct HSFloatingIndex* floating_index; // for floating focus, may be NULL
+    int             layout_generation; // incremented on frame tree changes
+    GString*        layout_cache[2]; // output of layout and dump, may be NULL
+    int             layout_cache_generation[2];
+    int             layout_cache_style; // tree style of layout_cache[0]
     bool            floating;
     int             flags;
     struct HSStack* stack;
@@ -28,6 +28,7 @@
 
 // globals
 static const char*   g_tree_style = "                "; /* the one from layout.c */
+int g_tree_style_generation = 0;
 
 time_t get_monotonic_timestamp() {
     struct timespec ts;
@@ -45,6 +46,24 @@ time_t get_monotonic_timestamp() {
     return ts.tv_sec;
 }
 
+long long get_monotonic_msec() {
+    struct timespec ts;
+#if defined(__MACH__) && ! defined(CLOCK_REALTIME)
+    // the system clock counts the time since boot
+    clock_serv_t cclock;
+    mach_timespec_t mts;
+    host_get_clock_service(mach_host_self(), SYSTEM_CLOCK, &cclock);
+    clock_get_time(cclock, &mts);
+    mach_port_deallocate(mach_task_self(), cclock);
+    ts.tv_sec = mts.tv_sec;
+    ts.tv_nsec = mts.tv_nsec;
+#else
+    // unlike CLOCK_REALTIME, it does not jump if the date is changed
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 /// print a printf-like message to stderr and exit
 // from dwm.c
 void die(const char *errstr, ...) {
@@ -407,6 +426,7 @@ void set_window_double_border(Display *dpy, Window win, int ibw,
 
 void reload_tree_style() {
     g_tree_style = settings_find_string("tree_style");
+    g_tree_style_generation++;
     if (g_utf8_strlen(g_tree_style, -1) < 8) {
         g_warning("too few characters in setting tree_style\n");
         // ensure that it is long enough
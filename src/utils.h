@@ -54,6 +54,8 @@ typedef struct HSTreeInterface {
 } HSTreeInterface;
 
 void reload_tree_style(); // fetch again the tree style setting
+// incremented by each reload_tree_style()
+extern int g_tree_style_generation;
 void tree_print_to(HSTreeInterface* intface, GString* output);
 
 
@@ -70,6 +72,8 @@ bool string_to_bool(const char* string, bool oldvalue);
 const char* strlasttoken(const char* str, const char* delim);
 
 time_t get_monotonic_timestamp();
+// milliseconds of a clock that never jumps, e.g. for timeouts
+long long get_monotonic_msec();
 
 // duplicates an argument-vector
 char** argv_duplicate(int argc, char** argv);